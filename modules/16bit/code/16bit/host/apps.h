@@ -0,0 +1,38 @@
+#pragma once
+
+// All apps compiled into one host binary.
+// The firmware compiles a single app per binary (see ../main.cpp); on the host
+// we want to pick the app at runtime, so every app and its implementation are
+// pulled into this translation unit instead.
+
+#include <string.h>
+#include "audio/apps/interfaces/audio_app.h"
+#include "audio/apps/noop_app.h"
+#include "audio/apps/sampler_app.h"
+#include "audio/apps/polysynth_app.h"
+#include "audio/apps/fxrack_app.h"
+#include "audio/apps/elab_app.h"
+
+#include "src/audio/apps/noop_app.cpp"
+#include "src/audio/apps/polysynth_app.cpp"
+#include "src/audio/apps/fxrack_app.cpp"
+#include "src/audio/apps/elab_app.cpp"
+
+#define HOST_APP_NAMES "noop, sampler, polysynth, fxrack, elab"
+
+// Returns nullptr for an unknown app name
+inline AudioApp* loadHostApp(const char* name) {
+    if (strcmp(name, "noop") == 0) {
+        return NoopApp::getInstance();
+    } else if (strcmp(name, "sampler") == 0) {
+        return SamplerApp::getInstance();
+    } else if (strcmp(name, "polysynth") == 0) {
+        return PolySynthApp::getInstance();
+    } else if (strcmp(name, "fxrack") == 0) {
+        return FXRackApp::getInstance();
+    } else if (strcmp(name, "elab") == 0) {
+        return ElabApp::getInstance();
+    }
+
+    return nullptr;
+}
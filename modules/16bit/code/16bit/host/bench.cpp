@@ -0,0 +1,568 @@
+// bm-bench: micro-benchmarks for the DSP building blocks.
+//
+// Each suite times a component the way the apps drive it and prints the cost
+// per sample, plus a quality figure where one makes sense. Host timings
+// don't translate 1:1 to the RP2350, but ratios between variants do.
+//
+// Usage: bm-bench [suite...]   (no arguments runs every suite)
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <chrono>
+#include <vector>
+
+#include "boot.h"
+#include "audio/gen/Sine.h"
+#include "audio/gen/Saw.h"
+#include "audio/gen/Tri.h"
+#include "audio/gen/Square.h"
+#include "audio/gen/BlepSaw.h"
+#include "audio/gen/BlepSquare.h"
+#include "audio/gen/BlepTri.h"
+#include "audio/gen/Wavetable.h"
+#include "audio/env/AttackHoldRelease.h"
+#include "audio/mod/SVF.h"
+#include "audio/mod/Biquad.h"
+#include "audio/mod/BiquadCascade.h"
+#include "audio/tools/VoiceEngine.h"
+#include "audio/tools/fastmath.h"
+#include "audio/apps/fx/filter_fx.h"
+#include "audio/apps/fx/delay_fx.h"
+#include "audio/apps/fx/metalverb_fx.h"
+#include "audio/apps/fx/rumble_fx.h"
+
+#define SAMPLE_RATE 44100
+#define BENCH_SAMPLES (SAMPLE_RATE * 20)
+
+// Keeps the optimiser from dropping the work being timed
+volatile float benchSink = 0.0f;
+
+// Accuracy checks that went over their bound; main exits nonzero if any did
+int benchFailures = 0;
+
+// Runs `render` over BENCH_SAMPLES samples in AUDIO_BLOCK_SIZE blocks and
+// returns the cost in ns per sample (best of 3 runs)
+template <typename Render>
+double nsPerSample(Render render) {
+    float block[AUDIO_BLOCK_SIZE];
+    double best = 1e30;
+
+    for (int run = 0; run < 3; run++) {
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t done = 0; done < BENCH_SAMPLES; done += AUDIO_BLOCK_SIZE) {
+            render(block, AUDIO_BLOCK_SIZE);
+            benchSink = benchSink + block[0];
+        }
+        std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        best = fmin(best, elapsed.count() / BENCH_SAMPLES);
+    }
+
+    return best;
+}
+
+// Energy that isn't on a harmonic of `frequency`, relative to the total, in
+// dB. For an oscillator that's its aliasing: fit every harmonic below Nyquist
+// (Hann-windowed projection) and measure what's left over.
+double aliasDb(AudioGenerator* generator, float frequency) {
+    const int n = 16384;
+    std::vector<double> x(n), window(n), fit(n, 0.0);
+
+    generator->reset();
+    generator->setFrequency(frequency);
+    double windowSum = 0.0, mean = 0.0;
+    for (int i = 0; i < n; i++) {
+        x[i] = generator->getSample();
+        window[i] = 0.5 - 0.5 * cos(2.0 * M_PI * i / n);
+        windowSum += window[i];
+        mean += window[i] * x[i];
+    }
+    mean /= windowSum;
+
+    // The phase increment is quantised, so fit the frequency actually played
+    double cycles = (double)(uint32_t)(frequency * (4294967296.0f / SAMPLE_RATE)) / 4294967296.0;
+    for (int k = 1; k * cycles < 0.5; k++) {
+        double a = 0.0, b = 0.0;
+        for (int i = 0; i < n; i++) {
+            double angle = 2.0 * M_PI * k * cycles * i;
+            a += window[i] * (x[i] - mean) * cos(angle);
+            b += window[i] * (x[i] - mean) * sin(angle);
+        }
+        a *= 2.0 / windowSum;
+        b *= 2.0 / windowSum;
+        for (int i = 0; i < n; i++) {
+            double angle = 2.0 * M_PI * k * cycles * i;
+            fit[i] += a * cos(angle) + b * sin(angle);
+        }
+    }
+
+    double residual = 0.0, total = 0.0;
+    for (int i = 0; i < n; i++) {
+        double centred = x[i] - mean;
+        residual += window[i] * (centred - fit[i]) * (centred - fit[i]);
+        total += window[i] * centred * centred;
+    }
+    return 10.0 * log10(residual / total);
+}
+
+// Oscillators: cost through the AudioGenerator interface (as Voice calls
+// them) and aliasing at a low, mid and high note.
+void benchOscillators() {
+    Sine sine;
+    Saw saw;
+    Tri tri;
+    Square square;
+    BlepSaw blSaw;
+    BlepTri blTri;
+    BlepSquare blSquare;
+    // Slot 99 is never uploaded, so this is the built-in band-limited saw
+    WavetableBank::getInstance()->load(99);
+    Wavetable wavetable;
+
+    struct {
+        const char* name;
+        AudioGenerator* generator;
+    } oscillators[] = {
+        {"sine", &sine},
+        {"saw", &saw},
+        {"tri", &tri},
+        {"square", &square},
+        {"bl-saw", &blSaw},
+        {"bl-tri", &blTri},
+        {"bl-square", &blSquare},
+        {"wt-saw", &wavetable},
+    };
+
+    const float aliasNotes[] = {220.0f, 1760.0f, 4186.0f};
+
+    printf("%-10s %10s %12s %12s %12s\n", "osc", "ns/sample", "alias@220", "alias@1760", "alias@4186");
+    for (auto& osc : oscillators) {
+        AudioGenerator* generator = osc.generator;
+        generator->init(audioManager);
+        generator->setFrequency(440.0f);
+        wavetable.updateCache();
+
+        double ns = nsPerSample([generator](float* out, size_t frames) {
+            for (size_t i = 0; i < frames; i++) {
+                out[i] = generator->getSample();
+            }
+        });
+
+        printf("%-10s %10.2f", osc.name, ns);
+        for (float note : aliasNotes) {
+            printf(" %10.1fdB", aliasDb(generator, note));
+        }
+        printf("\n");
+    }
+}
+
+// Polyphony: a chord of held voices rendered per sample through the
+// AudioGenerator and Envelope interfaces (the old Voice path) against the
+// VoiceEngine's per-block loops, in ns per voice and sample. The "+lpf" row
+// adds a voice filter swept by its envelope: per sample through SVF, at
+// control rate in the engine.
+void benchVoices() {
+    const uint8_t totalVoices = 16;
+    Saw saws[totalVoices];
+    BlepSaw blSaws[totalVoices];
+    AudioGenerator* sawVoices[totalVoices];
+    AudioGenerator* blSawVoices[totalVoices];
+    for (uint8_t v = 0; v < totalVoices; v++) {
+        sawVoices[v] = &saws[v];
+        blSawVoices[v] = &blSaws[v];
+    }
+    AttackHoldReleaseEnvelope* envelopes[totalVoices];
+    SVF* filters[totalVoices];
+    VoiceEngine engine;
+
+    struct {
+        const char* name;
+        AudioGenerator** generators;
+        VoiceWaveform waveform;
+        bool filter;
+    } waveforms[] = {
+        {"saw", sawVoices, VOICE_WAVE_SAW, false},
+        {"bl-saw", blSawVoices, VOICE_WAVE_BL_SAW, false},
+        {"bl-saw+lpf", blSawVoices, VOICE_WAVE_BL_SAW, true},
+    };
+
+    printf("%-10s %14s %14s %8s\n", "osc", "virtual ns/vs", "engine ns/vs", "speedup");
+    for (auto& wave : waveforms) {
+        AudioGenerator** generators = wave.generators;
+        engine.init(audioManager, totalVoices);
+        engine.setWaveform(wave.waveform);
+        engine.setFilterCutoff(wave.filter ? 800.0f : VOICE_FILTER_MAX_CUTOFF);
+        engine.setFilterEnvAmount(wave.filter ? 3.0f : 0.0f);
+        for (uint8_t v = 0; v < totalVoices; v++) {
+            uint8_t note = 48 + v * 2;
+            generators[v]->init(audioManager);
+            generators[v]->setFrequency(MIDI::midiNoteToFrequency(note));
+            envelopes[v] = new AttackHoldReleaseEnvelope(10.0f, 500.0f);
+            envelopes[v]->init(audioManager);
+            envelopes[v]->setTrigger(true);
+            filters[v] = new SVF(SVF::LOWPASS);
+            filters[v]->init(audioManager);
+            engine.noteOn(v, note, 0.8f);
+        }
+
+        double virtualNs = nsPerSample([&](float* out, size_t frames) {
+            for (size_t n = 0; n < frames; n++) {
+                out[n] = 0.0f;
+            }
+            for (uint8_t v = 0; v < totalVoices; v++) {
+                if (!wave.filter) {
+                    for (size_t n = 0; n < frames; n++) {
+                        out[n] += envelopes[v]->process(generators[v]->getSample()) * 0.8f;
+                    }
+                    continue;
+                }
+                for (size_t n = 0; n < frames; n++) {
+                    float sample = generators[v]->getSample();
+                    filters[v]->setCutoff(800.0f * exp2f(3.0f * envelopes[v]->getLevel()));
+                    out[n] += envelopes[v]->process(filters[v]->process(sample)) * 0.8f;
+                }
+            }
+        }) / totalVoices;
+
+        double engineNs = nsPerSample([&](float* out, size_t frames) {
+            for (size_t n = 0; n < frames; n++) {
+                out[n] = 0.0f;
+            }
+            engine.render(out, frames);
+        }) / totalVoices;
+
+        printf("%-10s %14.2f %14.2f %7.2fx\n", wave.name, virtualNs, engineNs, virtualNs / engineNs);
+        for (uint8_t v = 0; v < totalVoices; v++) {
+            delete envelopes[v];
+            delete filters[v];
+        }
+    }
+}
+
+// Effects: each AudioFX on a saw, with every parameter at half and the gate
+// toggling every 100ms so envelopes and modulation keep moving.
+void benchFX() {
+    FilterFX filter;
+    DelayFX delay;
+    MetalVerbFX metalVerb;
+    RumbleFX rumble;
+
+    struct {
+        const char* name;
+        AudioFX* fx;
+    } effects[] = {
+        {"filter", &filter},
+        {"delay", &delay},
+        {"metalverb", &metalVerb},
+        {"rumble", &rumble},
+    };
+
+    Saw saw;
+    saw.init(audioManager);
+    saw.setFrequency(110.0f);
+
+    printf("%-10s %10s %10s %8s\n", "fx", "ns/sample", "block", "speedup");
+    for (auto& effect : effects) {
+        AudioFX* fx = effect.fx;
+        fx->init(audioManager);
+        fx->setBPM(120);
+        for (uint8_t parameter = 0; parameter < fx->getParameterCount(); parameter++) {
+            fx->setParameter(parameter, 0.5f);
+        }
+
+        uint32_t sample = 0;
+        double ns = nsPerSample([&](float* out, size_t frames) {
+            for (size_t n = 0; n < frames; n++, sample++) {
+                if (sample % (SAMPLE_RATE / 10) == 0) {
+                    fx->setGate((sample / (SAMPLE_RATE / 10)) % 2 == 0);
+                }
+                out[n] = fx->process(saw.getSample());
+            }
+        });
+
+        // The same through processBlock() (mono, L = R), the gate moving
+        // on the block boundary
+        float right[AUDIO_BLOCK_SIZE];
+        sample = 0;
+        double blockNs = nsPerSample([&](float* out, size_t frames) {
+            if (sample % (SAMPLE_RATE / 10) < frames) {
+                fx->setGate((sample / (SAMPLE_RATE / 10)) % 2 == 0);
+            }
+            for (size_t n = 0; n < frames; n++) {
+                out[n] = saw.getSample();
+                right[n] = out[n];
+            }
+            fx->processBlock(out, right, frames);
+            sample += frames;
+        });
+
+        printf("%-10s %10.2f %10.2f %7.2fx\n", effect.name, ns, blockNs, ns / blockNs);
+    }
+
+    // The bare delay line per read mode, with the tempo changing every 50ms
+    // so the delay time is always gliding between whole samples
+    struct {
+        const char* name;
+        DelayInterpolation mode;
+    } reads[] = {
+        {"none", DELAY_INTERP_NONE},
+        {"linear", DELAY_INTERP_LINEAR},
+        {"hermite", DELAY_INTERP_HERMITE},
+        {"allpass", DELAY_INTERP_ALLPASS},
+    };
+
+    printf("\n%-10s %10s\n", "read", "ns/sample");
+    for (auto& read : reads) {
+        Delay line(1000);
+        line.init(audioManager);
+        line.setInterpolation(read.mode);
+        line.setBPM(120);
+        line.setDelayBeats(0.5f);
+        line.setFeedback(0.5f);
+        line.setWet(0.5f);
+
+        uint32_t sample = 0;
+        double ns = nsPerSample([&](float* out, size_t frames) {
+            for (size_t n = 0; n < frames; n++, sample++) {
+                if (sample % (SAMPLE_RATE / 20) == 0) {
+                    line.setBPM(100 + (sample / (SAMPLE_RATE / 20)) % 40);
+                }
+                out[n] = line.process(saw.getSample());
+            }
+        });
+
+        printf("%-10s %10.2f\n", read.name, ns);
+    }
+
+    // The same with linear reads per storage format
+    struct {
+        const char* name;
+        DelayStorage storage;
+        size_t bytesPerSample;
+    } formats[] = {
+        {"float", DELAY_STORAGE_FLOAT, sizeof(float)},
+        {"int16", DELAY_STORAGE_INT16, sizeof(int16_t)},
+        {"dither", DELAY_STORAGE_INT16_DITHER, sizeof(int16_t)},
+    };
+
+    printf("\n%-10s %10s %10s\n", "storage", "ns/sample", "KB/second");
+    for (auto& format : formats) {
+        Delay line(1000, format.storage);
+        line.init(audioManager);
+        line.setBPM(120);
+        line.setDelayBeats(0.5f);
+        line.setFeedback(0.5f);
+        line.setWet(0.5f);
+
+        uint32_t sample = 0;
+        double ns = nsPerSample([&](float* out, size_t frames) {
+            for (size_t n = 0; n < frames; n++, sample++) {
+                if (sample % (SAMPLE_RATE / 20) == 0) {
+                    line.setBPM(100 + (sample / (SAMPLE_RATE / 20)) % 40);
+                }
+                out[n] = line.process(saw.getSample());
+            }
+        });
+
+        printf("%-10s %10.2f %10.1f\n", format.name, ns, SAMPLE_RATE * format.bytesPerSample / 1024.0);
+    }
+}
+
+// Biquads: the cascade per section count against chained Biquads, then
+// what a knob sweep costs per cutoff change with and without the cache.
+void benchBiquad() {
+    Saw saw;
+    saw.init(audioManager);
+    saw.setFrequency(110.0f);
+
+    printf("%-10s %14s %14s\n", "sections", "Biquad ns/s", "cascade ns/s");
+    for (uint8_t sections : {1, 2, 4, 8}) {
+        std::vector<Biquad> chain(sections, Biquad(Biquad::LOWPASS));
+        BiquadCascade cascade(sections);
+        for (uint8_t s = 0; s < sections; s++) {
+            chain[s].init(audioManager);
+            chain[s].setCutoff(2000.0f);
+            cascade.setSection(s, BIQUAD_LOWPASS, 2000.0f, 0.707f);
+        }
+        cascade.init(audioManager);
+
+        double chainNs = nsPerSample([&](float* out, size_t frames) {
+            for (size_t n = 0; n < frames; n++) {
+                float x = saw.getSample();
+                for (Biquad& biquad : chain) {
+                    x = biquad.process(x);
+                }
+                out[n] = x;
+            }
+        });
+        double cascadeNs = nsPerSample([&](float* out, size_t frames) {
+            for (size_t n = 0; n < frames; n++) {
+                out[n] = saw.getSample();
+            }
+            cascade.processBlock(out, frames);
+        });
+        printf("%-10d %14.2f %14.2f\n", sections, chainNs, cascadeNs);
+    }
+
+    // A CV knob swept up and down between 100Hz and 10kHz, 50 updates a second
+    const int updates = 1000;
+    std::vector<float> sweep(updates);
+    for (int i = 0; i < updates; i++) {
+        float position = fabsf(fmodf(i / 100.0f, 2.0f) - 1.0f);
+        sweep[i] = 100.0f * powf(100.0f, position);
+    }
+
+    BiquadCache* cache = BiquadCache::getInstance();
+    uint32_t hitsBefore = cache->getHits(), missesBefore = cache->getMisses();
+    BiquadCoefficients coefficients;
+    auto timeUpdates = [&](bool cached) {
+        double best = 1e30;
+        for (int run = 0; run < 3; run++) {
+            auto start = std::chrono::steady_clock::now();
+            for (float cutoff : sweep) {
+                if (cached) {
+                    coefficients = cache->get(BIQUAD_PEAK, cutoff, 2.0f, 6.0f);
+                } else {
+                    BiquadCache::design(BIQUAD_PEAK, cutoff, 2.0f, 6.0f, SAMPLE_RATE, coefficients);
+                }
+                benchSink = benchSink + coefficients.b0;
+            }
+            std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+            best = fmin(best, elapsed.count() / updates);
+        }
+        return best;
+    };
+    double designNs = timeUpdates(false);
+    double cachedNs = timeUpdates(true);
+    uint32_t hits = cache->getHits() - hitsBefore, misses = cache->getMisses() - missesBefore;
+    printf("cutoff change: %.1f ns designed, %.1f ns through the cache (%.0f%% hits)\n",
+        designNs, cachedNs, 100.0 * hits / (hits + misses));
+}
+
+// Times fn over `count` inputs spread across [low, high], in ns per call
+template <typename Fn>
+double nsPerCall(Fn fn, float low, float high) {
+    const int count = 1 << 20;
+    double best = 1e30;
+    for (int run = 0; run < 3; run++) {
+        float x = low, step = (high - low) / count, sum = 0.0f;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < count; i++, x += step) {
+            sum += fn(x);
+        }
+        std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        benchSink = benchSink + sum;
+        best = fmin(best, elapsed.count() / count);
+    }
+    return best;
+}
+
+// fastmath.h: worst error against libm (in double) over each function's
+// documented range, and the cost of both. These are the accuracy checks
+// behind the bounds listed in fastmath.h: going over one prints FAIL and
+// makes bm-bench exit nonzero. Desktop libms are fast, so the timings only
+// say much on the RP2350 side of things.
+void benchMath() {
+    struct {
+        const char* name;
+        float (*fast)(float);
+        float (*libm)(float);
+        double (*reference)(double);
+        float low, high;
+        bool relative;
+        double bound; // As documented in fastmath.h
+    } functions[] = {
+        {"exp2", fastExp2, exp2f, [](double x) { return exp2(x); }, -126.0f, 127.0f, true, 2e-7},
+        {"exp", fastExp, expf, [](double x) { return exp(x); }, -20.0f, 20.0f, true, 2e-6},
+        {"log2", fastLog2, log2f, [](double x) { return log2(x); }, 1e-6f, 1.0f, false, 1e-6},
+        {"sin", fastSin, sinf, [](double x) { return sin(x); }, -2.0f * (float)M_PI, 2.0f * (float)M_PI, false, 1e-6},
+        {"cos", fastCos, cosf, [](double x) { return cos(x); }, -2.0f * (float)M_PI, 2.0f * (float)M_PI, false, 1e-6},
+        {"tan", fastTan, tanf, [](double x) { return tan(x); }, -1.5f, 1.5f, true, 1e-6},
+        {"tanh", fastTanh, tanhf, [](double x) { return tanh(x); }, -10.0f, 10.0f, false, 0.025},
+        {"dbToGain", dbToGain, [](float db) { return powf(10.0f, db / 20.0f); },
+            [](double db) { return pow(10.0, db / 20.0); }, -120.0f, 24.0f, true, 1e-6},
+    };
+
+    printf("%-10s %12s %10s %10s %10s\n", "fn", "max error", "bound", "fast ns", "libm ns");
+    for (auto& fn : functions) {
+        const int steps = 1000000;
+        double worst = 0.0;
+        for (int i = 0; i <= steps; i++) {
+            float x = fn.low + (fn.high - fn.low) * ((double)i / steps);
+            double expected = fn.reference(x);
+            double error = fabs(fn.fast(x) - expected);
+            if (fn.relative) {
+                error /= fabs(expected);
+            }
+            worst = fmax(worst, error);
+        }
+
+        bool failed = worst >= fn.bound;
+        benchFailures += failed;
+        printf("%-10s %11.2e%s %10.3g %10.2f %10.2f%s\n", fn.name, worst, fn.relative ? "r" : "a", fn.bound,
+            nsPerCall(fn.fast, fn.low, fn.high), nsPerCall(fn.libm, fn.low, fn.high), failed ? "  FAIL" : "");
+    }
+
+    // pow over the ranges the apps map knobs through (Hz, ratios)
+    double worst = 0.0;
+    for (int i = 0; i <= 1000; i++) {
+        for (int j = 0; j <= 100; j++) {
+            float base = 1.0f + i * 0.999f, exponent = -2.0f + j * 0.04f;
+            double expected = pow(base, exponent);
+            worst = fmax(worst, fabs(fastPow(base, exponent) - expected) / expected);
+        }
+    }
+    const double powBound = 2e-6;
+    bool failed = worst >= powBound;
+    benchFailures += failed;
+    printf("%-10s %11.2er %10.3g%s\n", "pow", worst, powBound, failed ? "  FAIL" : "");
+}
+
+struct BenchSuite {
+    const char* name;
+    void (*run)();
+};
+
+BenchSuite suites[] = {
+    {"osc", benchOscillators},
+    {"voices", benchVoices},
+    {"fx", benchFX},
+    {"biquad", benchBiquad},
+    {"math", benchMath},
+};
+
+int main(int argc, char** argv) {
+    if (bootHostApp("noop", SAMPLE_RATE) == nullptr) {
+        return 1;
+    }
+
+    bool ranAny = false;
+    for (BenchSuite& suite : suites) {
+        bool selected = argc < 2;
+        for (int i = 1; i < argc; i++) {
+            selected |= strcmp(argv[i], suite.name) == 0;
+        }
+        if (!selected) {
+            continue;
+        }
+
+        printf("== %s (block %d)\n", suite.name, AUDIO_BLOCK_SIZE);
+        suite.run();
+        ranAny = true;
+    }
+
+    if (!ranAny) {
+        printf("Usage: bm-bench [suite...]\nSuites:");
+        for (BenchSuite& suite : suites) {
+            printf(" %s", suite.name);
+        }
+        printf("\n");
+        return 1;
+    }
+
+    if (benchFailures > 0) {
+        printf("%d accuracy check(s) failed\n", benchFailures);
+        return 1;
+    }
+    return 0;
+}
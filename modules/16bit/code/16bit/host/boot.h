@@ -0,0 +1,45 @@
+#pragma once
+
+// Shared start-up for the host tools: brings up PSRAM, the filesystem and the
+// audio manager in the same order as the firmware's main(), which in turn
+// calls app->init() through the audio start callback.
+
+#include <stdio.h>
+
+#include "io.h"
+#include "midi.h"
+#include "fs/FS.h"
+#include "psram.h"
+#include "audio/manager.h"
+#include "api/web_serial.h"
+#include "apps.h"
+
+FS *fs = FS::getInstance();
+PSRAM *psram = PSRAM::getInstance();
+AudioManager *audioManager = AudioManager::getInstance();
+
+AudioApp* app = nullptr;
+
+void onAudioStartCallback() {
+    app->init();
+}
+
+// Returns nullptr (and prints why) if the app is unknown or fails to boot
+inline AudioApp* bootHostApp(const char* name, uint32_t sampleRate) {
+    app = loadHostApp(name);
+    if (app == nullptr) {
+        printf("Unknown app: %s (apps: %s)\n", name, HOST_APP_NAMES);
+        return nullptr;
+    }
+
+    psram->init();
+    if (!fs->init()) {
+        printf("Failed to initialise the host filesystem\n");
+        return nullptr;
+    }
+
+    audioManager->setOnAudioStartCallback(onAudioStartCallback);
+    audioManager->init(sampleRate);
+
+    return app;
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+// CV automation for the host tools.
+// A curve file is plain text, one breakpoint per line:
+//
+//   # seconds  value (0.0 - 1.0, i.e. IO::normalizeCV of the ADC reading)
+//   0.0        0.0
+//   2.0        1.0
+//   4.0        0.25
+//
+// The value is linearly interpolated between breakpoints and held after the
+// last one. Blank lines and lines starting with '#' are ignored.
+
+#include <stdio.h>
+#include <stdint.h>
+#include <vector>
+
+struct CVPoint {
+    uint64_t frame;
+    float value;
+};
+
+class CVCurve {
+private:
+    std::vector<CVPoint> points;
+    size_t cursor = 0;
+
+public:
+    bool load(const char* path, uint32_t sampleRate) {
+        FILE* file = fopen(path, "r");
+        if (file == nullptr) {
+            printf("Failed to open CV curve: %s\n", path);
+            return false;
+        }
+
+        char line[256];
+        int lineNumber = 0;
+        while (fgets(line, sizeof(line), file)) {
+            lineNumber++;
+            double seconds;
+            float value;
+            char first = 0;
+            if (sscanf(line, " %c", &first) != 1 || first == '#') {
+                continue;
+            }
+            if (sscanf(line, "%lf %f", &seconds, &value) != 2 || seconds < 0.0) {
+                printf("%s:%d: expected '<seconds> <value>'\n", path, lineNumber);
+                fclose(file);
+                return false;
+            }
+            if (!points.empty() && seconds * sampleRate < points.back().frame) {
+                printf("%s:%d: breakpoints must be in time order\n", path, lineNumber);
+                fclose(file);
+                return false;
+            }
+
+            value = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+            points.push_back({(uint64_t)(seconds * sampleRate + 0.5), value});
+        }
+        fclose(file);
+
+        if (points.empty()) {
+            printf("CV curve has no breakpoints: %s\n", path);
+            return false;
+        }
+
+        return true;
+    }
+
+    bool empty() const {
+        return points.empty();
+    }
+
+    uint64_t lastFrame() const {
+        return points.empty() ? 0 : points.back().frame;
+    }
+
+    // Raw 12-bit ADC value at `frame`, as IO would pass it to the CV callbacks.
+    // Frames must be queried in non-decreasing order.
+    uint16_t valueAt(uint64_t frame) {
+        while (cursor + 1 < points.size() && points[cursor + 1].frame <= frame) {
+            cursor++;
+        }
+
+        const CVPoint& a = points[cursor];
+        float value = a.value;
+        if (frame > a.frame && cursor + 1 < points.size()) {
+            const CVPoint& b = points[cursor + 1];
+            float t = (float)(frame - a.frame) / (float)(b.frame - a.frame);
+            value = a.value + (b.value - a.value) * t;
+        }
+
+        return (uint16_t)(value * 4095.0f + 0.5f);
+    }
+};
@@ -0,0 +1,77 @@
+// bm-host: run one 16bit app on the host and report how fast it renders.
+//
+// It boots the app like the firmware's main() does, then plays a fixed
+// pattern (a chord retriggered every half second, plus a sine on the audio
+// inputs) through processBlock() for the given number of seconds. Point
+// perf/valgrind at this to profile an app's DSP.
+//
+// Usage: bm-host <app> [seconds]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <chrono>
+
+#include "boot.h"
+
+#define SAMPLE_RATE 44100
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        printf("Usage: bm-host <app> [seconds]\n");
+        printf("Apps: %s\n", HOST_APP_NAMES);
+        return 1;
+    }
+
+    float seconds = argc > 2 ? atof(argv[2]) : 10.0f;
+
+    if (bootHostApp(argv[1], SAMPLE_RATE) == nullptr) {
+        return 1;
+    }
+
+    const uint8_t chord[] = {48, 55, 60, 64, 67};
+    const uint32_t notePeriod = SAMPLE_RATE / 2;
+    const uint32_t noteLength = SAMPLE_RATE / 4;
+    const uint64_t totalFrames = (uint64_t)(seconds * SAMPLE_RATE);
+
+    AudioInput input[AUDIO_BLOCK_SIZE];
+    AudioOutput output[AUDIO_BLOCK_SIZE];
+    float peak = 0.0f;
+    float inputPhase = 0.0f;
+
+    auto startTime = std::chrono::steady_clock::now();
+
+    for (uint64_t frame = 0; frame < totalFrames; frame += AUDIO_BLOCK_SIZE) {
+        uint32_t patternPos = frame % notePeriod;
+        if (patternPos < AUDIO_BLOCK_SIZE) {
+            for (uint8_t note : chord) {
+                app->noteOnCallback(0, note, 100);
+            }
+        } else if (patternPos >= noteLength && patternPos - noteLength < AUDIO_BLOCK_SIZE) {
+            for (uint8_t note : chord) {
+                app->noteOffCallback(0, note, 0);
+            }
+        }
+
+        for (size_t n = 0; n < AUDIO_BLOCK_SIZE; n++) {
+            inputPhase += 220.0f / SAMPLE_RATE;
+            if (inputPhase >= 1.0f) inputPhase -= 1.0f;
+            input[n].left = 0.5f * sinf(2.0f * (float)M_PI * inputPhase);
+            input[n].right = input[n].left;
+        }
+
+        app->processBlock(input, output, AUDIO_BLOCK_SIZE);
+
+        for (size_t n = 0; n < AUDIO_BLOCK_SIZE; n++) {
+            peak = fmaxf(peak, fmaxf(fabsf(output[n].left), fabsf(output[n].right)));
+        }
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+    double renderedSeconds = (double)totalFrames / SAMPLE_RATE;
+
+    printf("%s: rendered %.2fs of audio in %.3fs (%.1fx realtime, block %d, peak %.3f)\n",
+        argv[1], renderedSeconds, elapsed.count(), renderedSeconds / elapsed.count(), AUDIO_BLOCK_SIZE, peak);
+
+    return 0;
+}
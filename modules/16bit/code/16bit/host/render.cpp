@@ -0,0 +1,239 @@
+// bm-render: render a 16bit app offline, from a MIDI file to a WAV file.
+//
+// The app is booted like the firmware's main() does and driven by:
+//   - a Standard MIDI File (notes, CCs and tempo -> bpmChangeCallback)
+//   - optional CV1/CV2 automation curves (see cv_curve.h)
+//   - an optional input WAV on the audio inputs (e.g. for fxrack)
+//
+// MIDI events are delivered on their exact frame: a block is split at each
+// event, so processBlock() may see fewer than AUDIO_BLOCK_SIZE frames.
+// Without events the blocks stay on the same AUDIO_BLOCK_SIZE grid as the
+// firmware. CVs are polled once per block with the same change threshold IO
+// uses, and update() runs once per block like the firmware's main loop.
+//
+// Only processBlock() and the callbacks are timed, so the reported speed is
+// comparable between builds (A/B a change, or catch a regression before
+// flashing).
+//
+// Usage: bm-render <app> [options]
+//   -m <file.mid>      MIDI file to play
+//   -i <file.wav>      audio input (mono or stereo)
+//   --cv1 <curve.txt>  CV1 automation
+//   --cv2 <curve.txt>  CV2 automation
+//   -o <file.wav>      output file (default: <app>.wav)
+//   -t <seconds>       render length (default: until the inputs end, plus the tail)
+//   --tail <seconds>   extra time after the last input (default: 2)
+//   --float            write 32-bit float instead of 16-bit PCM
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "boot.h"
+#include "smf.h"
+#include "wav.h"
+#include "cv_curve.h"
+
+#define SAMPLE_RATE 44100
+
+// Same as main.cpp's io->setCVxUpdateCallback(..., 50)
+#define CV_DIFF_THRESHOLD 50
+
+struct CVInput {
+    CVCurve curve;
+    bool firstRun = true;
+    uint16_t value = 0;
+
+    // Mirrors IO::update(): only report changes bigger than the threshold
+    bool poll(uint64_t frame) {
+        if (curve.empty()) {
+            return false;
+        }
+
+        uint16_t newValue = curve.valueAt(frame);
+        if (firstRun || abs(value - newValue) > CV_DIFF_THRESHOLD) {
+            firstRun = false;
+            value = newValue;
+            return true;
+        }
+        return false;
+    }
+};
+
+static void printUsage() {
+    printf("Usage: bm-render <app> [-m song.mid] [-i input.wav] [--cv1 curve.txt] [--cv2 curve.txt]\n");
+    printf("                       [-o out.wav] [-t seconds] [--tail seconds] [--float]\n");
+    printf("Apps: %s\n", HOST_APP_NAMES);
+}
+
+static void dispatchEvent(AudioApp* app, const SmfEvent& event) {
+    switch (event.type) {
+        case SMF_NOTE_ON:
+            app->noteOnCallback(event.channel, event.data1, event.data2);
+            break;
+        case SMF_NOTE_OFF:
+            app->noteOffCallback(event.channel, event.data1, event.data2);
+            break;
+        case SMF_CONTROL_CHANGE:
+            app->ccChangeCallback(event.channel, event.data1, event.data2);
+            break;
+        case SMF_TEMPO:
+            app->bpmChangeCallback((int)(60000000.0f / event.tempo + 0.5f));
+            break;
+        case SMF_PITCH_BEND:
+            app->pitchBendCallback(event.channel, (int16_t)((event.data2 << 7) | event.data1) - MIDI_PITCH_BEND_CENTER);
+            break;
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2 || argv[1][0] == '-') {
+        printUsage();
+        return 1;
+    }
+
+    const char* appName = argv[1];
+    const char* midiPath = nullptr;
+    const char* inputPath = nullptr;
+    const char* cvPaths[2] = {nullptr, nullptr};
+    std::string outputPath = std::string(appName) + ".wav";
+    float seconds = -1.0f;
+    float tail = 2.0f;
+    bool writeFloat = false;
+
+    for (int i = 2; i < argc; i++) {
+        const char* arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (strcmp(arg, "-m") == 0 && hasValue) {
+            midiPath = argv[++i];
+        } else if (strcmp(arg, "-i") == 0 && hasValue) {
+            inputPath = argv[++i];
+        } else if (strcmp(arg, "--cv1") == 0 && hasValue) {
+            cvPaths[0] = argv[++i];
+        } else if (strcmp(arg, "--cv2") == 0 && hasValue) {
+            cvPaths[1] = argv[++i];
+        } else if (strcmp(arg, "-o") == 0 && hasValue) {
+            outputPath = argv[++i];
+        } else if (strcmp(arg, "-t") == 0 && hasValue) {
+            seconds = atof(argv[++i]);
+        } else if (strcmp(arg, "--tail") == 0 && hasValue) {
+            tail = atof(argv[++i]);
+        } else if (strcmp(arg, "--float") == 0) {
+            writeFloat = true;
+        } else {
+            printf("Unknown or incomplete option: %s\n", arg);
+            printUsage();
+            return 1;
+        }
+    }
+
+    // Load every input before booting, so a typo fails fast
+    std::vector<SmfEvent> events;
+    if (midiPath != nullptr && !loadSmf(midiPath, SAMPLE_RATE, events)) {
+        return 1;
+    }
+
+    WavData input;
+    if (inputPath != nullptr) {
+        if (!readWav(inputPath, input)) {
+            return 1;
+        }
+        if (input.sampleRate != SAMPLE_RATE) {
+            printf("Warning: %s is %u Hz, it will play at %d Hz\n", inputPath, input.sampleRate, SAMPLE_RATE);
+        }
+    }
+
+    CVInput cv[2];
+    for (int i = 0; i < 2; i++) {
+        if (cvPaths[i] != nullptr && !cv[i].curve.load(cvPaths[i], SAMPLE_RATE)) {
+            return 1;
+        }
+    }
+
+    uint64_t totalFrames;
+    if (seconds >= 0.0f) {
+        totalFrames = (uint64_t)(seconds * SAMPLE_RATE);
+    } else {
+        uint64_t lastFrame = input.frames();
+        if (!events.empty()) lastFrame = std::max(lastFrame, events.back().frame);
+        lastFrame = std::max(lastFrame, cv[0].curve.lastFrame());
+        lastFrame = std::max(lastFrame, cv[1].curve.lastFrame());
+        totalFrames = lastFrame + (uint64_t)(tail * SAMPLE_RATE);
+    }
+
+    if (bootHostApp(appName, SAMPLE_RATE) == nullptr) {
+        return 1;
+    }
+
+    std::vector<float> outLeft(totalFrames);
+    std::vector<float> outRight(totalFrames);
+    AudioInput inBlock[AUDIO_BLOCK_SIZE];
+    AudioOutput outBlock[AUDIO_BLOCK_SIZE];
+    size_t nextEvent = 0;
+    uint64_t blocks = 0;
+
+    auto startTime = std::chrono::steady_clock::now();
+
+    uint64_t frame = 0;
+    while (frame < totalFrames) {
+        while (nextEvent < events.size() && events[nextEvent].frame <= frame) {
+            dispatchEvent(app, events[nextEvent++]);
+        }
+
+        // Block boundary on the firmware's grid: control-rate work
+        if (frame % AUDIO_BLOCK_SIZE == 0) {
+            if (cv[0].poll(frame)) app->cv1UpdateCallback(cv[0].value);
+            if (cv[1].poll(frame)) app->cv2UpdateCallback(cv[1].value);
+            app->update();
+        }
+
+        uint64_t frames = AUDIO_BLOCK_SIZE - frame % AUDIO_BLOCK_SIZE;
+        frames = std::min(frames, totalFrames - frame);
+        if (nextEvent < events.size()) {
+            frames = std::min(frames, events[nextEvent].frame - frame);
+        }
+
+        for (uint64_t n = 0; n < frames; n++) {
+            uint64_t i = frame + n;
+            bool inRange = i < input.frames();
+            inBlock[n].left = inRange ? input.left[i] : 0.0f;
+            inBlock[n].right = inRange ? input.right[i] : 0.0f;
+        }
+
+        app->processBlock(inBlock, outBlock, frames);
+        blocks++;
+
+        for (uint64_t n = 0; n < frames; n++) {
+            outLeft[frame + n] = outBlock[n].left;
+            outRight[frame + n] = outBlock[n].right;
+        }
+
+        frame += frames;
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+
+    float peak = 0.0f;
+    for (uint64_t i = 0; i < totalFrames; i++) {
+        peak = fmaxf(peak, fmaxf(fabsf(outLeft[i]), fabsf(outRight[i])));
+    }
+
+    WavWriter writer;
+    if (!writer.open(outputPath.c_str(), SAMPLE_RATE, writeFloat)) {
+        return 1;
+    }
+    writer.write(outLeft.data(), outRight.data(), totalFrames);
+    writer.close();
+
+    double renderedSeconds = (double)totalFrames / SAMPLE_RATE;
+    printf("%s: rendered %.2fs of audio in %.3fs (%.1fx realtime, %zu events, %llu blocks of up to %d, peak %.3f%s)\n",
+        appName, renderedSeconds, elapsed.count(), renderedSeconds / elapsed.count(), events.size(),
+        (unsigned long long)blocks, AUDIO_BLOCK_SIZE, peak, peak > 1.0f ? " CLIPPED" : "");
+    printf("Wrote %s\n", outputPath.c_str());
+
+    return 0;
+}
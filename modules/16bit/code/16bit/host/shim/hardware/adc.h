@@ -0,0 +1,29 @@
+#pragma once
+
+// ADC stand-in. Conversions never run: the DMA capture ring keeps its idle
+// fill (2048, i.e. 0V audio / mid CV). Host tools feed audio and CV to the
+// apps directly instead.
+
+#include "pico/stdlib.h"
+
+#define DREQ_ADC 48
+
+typedef struct {
+    volatile uint32_t cs;
+    volatile uint32_t result;
+    volatile uint32_t fcs;
+    volatile uint32_t fifo;
+    volatile uint32_t div;
+} adc_hw_t;
+
+inline adc_hw_t bm_host_adc_hw;
+#define adc_hw (&bm_host_adc_hw)
+
+inline void adc_init() {}
+inline void adc_gpio_init(uint gpio) {}
+inline void adc_select_input(uint input) {}
+inline void adc_set_round_robin(uint input_mask) {}
+inline void adc_set_clkdiv(float clkdiv) {}
+inline void adc_fifo_setup(bool en, bool dreq_en, uint16_t dreq_thresh, bool err_in_fifo, bool byte_shift) {}
+inline void adc_fifo_drain() {}
+inline void adc_run(bool run) {}
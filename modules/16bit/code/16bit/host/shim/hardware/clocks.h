@@ -0,0 +1,18 @@
+#pragma once
+
+#include "pico/stdlib.h"
+
+enum clock_index {
+    clk_sys = 5,
+};
+
+inline uint32_t bm_host_sys_clock_khz = 150000;
+
+inline bool set_sys_clock_khz(uint32_t freq_khz, bool required) {
+    bm_host_sys_clock_khz = freq_khz;
+    return true;
+}
+
+inline uint32_t clock_get_hz(clock_index clk) {
+    return bm_host_sys_clock_khz * 1000;
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+// DMA stand-in. Channels can be claimed and configured, but nothing moves:
+// host tools never run the core1 audio loop that waits on them.
+
+#include "pico/stdlib.h"
+#include "hardware/pio.h"
+
+enum dma_channel_transfer_size {
+    DMA_SIZE_8 = 0,
+    DMA_SIZE_16 = 1,
+    DMA_SIZE_32 = 2,
+};
+
+#define DMA_CH0_CTRL_TRIG_EN_BITS 0x00000001u
+
+typedef struct {
+    uint32_t ctrl;
+} dma_channel_config;
+
+typedef struct {
+    volatile uint32_t read_addr;
+    volatile uint32_t write_addr;
+    volatile uint32_t transfer_count;
+    volatile uint32_t ctrl_trig;
+    volatile uint32_t al1_ctrl;
+    volatile uint32_t al1_read_addr;
+    volatile uint32_t al1_write_addr;
+    volatile uint32_t al1_transfer_count_trig;
+    volatile uint32_t al2_ctrl;
+    volatile uint32_t al2_transfer_count;
+    volatile uint32_t al2_read_addr;
+    volatile uint32_t al2_write_addr_trig;
+} dma_channel_hw_t;
+
+inline dma_channel_hw_t bm_host_dma_channels[16];
+inline uint16_t bm_host_dma_claimed = 0;
+
+inline int dma_claim_unused_channel(bool required) {
+    for (int i = 0; i < 16; i++) {
+        if (!(bm_host_dma_claimed & (1u << i))) {
+            bm_host_dma_claimed |= (1u << i);
+            return i;
+        }
+    }
+    return -1;
+}
+
+inline void dma_channel_unclaim(uint channel) {
+    bm_host_dma_claimed &= ~(1u << channel);
+}
+
+inline dma_channel_hw_t* dma_channel_hw_addr(uint channel) {
+    return &bm_host_dma_channels[channel];
+}
+
+inline dma_channel_config dma_channel_get_default_config(uint channel) {
+    return dma_channel_config{0};
+}
+
+inline void channel_config_set_transfer_data_size(dma_channel_config* c, dma_channel_transfer_size size) {}
+inline void channel_config_set_read_increment(dma_channel_config* c, bool incr) {}
+inline void channel_config_set_write_increment(dma_channel_config* c, bool incr) {}
+inline void channel_config_set_dreq(dma_channel_config* c, uint dreq) {}
+inline void channel_config_set_chain_to(dma_channel_config* c, uint chain_to) {}
+inline void channel_config_set_ring(dma_channel_config* c, bool write, uint size_bits) {}
+
+inline void dma_channel_configure(uint channel, const dma_channel_config* config, volatile void* write_addr,
+                                  const volatile void* read_addr, uint transfer_count, bool trigger) {
+    dma_channel_hw_t* hw = dma_channel_hw_addr(channel);
+    hw->write_addr = (uint32_t)(uintptr_t)write_addr;
+    hw->read_addr = (uint32_t)(uintptr_t)read_addr;
+    hw->transfer_count = transfer_count;
+}
+
+inline void dma_channel_set_read_addr(uint channel, const volatile void* read_addr, bool trigger) {
+    dma_channel_hw_addr(channel)->read_addr = (uint32_t)(uintptr_t)read_addr;
+}
+
+inline void dma_channel_start(uint channel) {}
+inline void dma_channel_abort(uint channel) {}
+inline void dma_channel_set_irq0_enabled(uint channel, bool enabled) {}
+inline void dma_channel_set_irq1_enabled(uint channel, bool enabled) {}
+inline bool dma_channel_get_irq0_status(uint channel) { return false; }
+inline bool dma_channel_get_irq1_status(uint channel) { return false; }
+inline void dma_channel_acknowledge_irq0(uint channel) {}
+inline void dma_channel_acknowledge_irq1(uint channel) {}
+
+inline uint pio_get_dreq(PIO pio, uint sm, bool is_tx) {
+    return 0;
+}
+
+inline void hw_set_bits(volatile uint32_t* addr, uint32_t mask) { *addr |= mask; }
+inline void hw_clear_bits(volatile uint32_t* addr, uint32_t mask) { *addr &= ~mask; }
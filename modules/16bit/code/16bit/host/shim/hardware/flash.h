@@ -0,0 +1,15 @@
+#pragma once
+
+// The host filesystem shim (lfs.h) never reaches the flash block device, but
+// pico_lfs.h still has to compile against these.
+
+#include "pico/stdlib.h"
+
+#define FLASH_PAGE_SIZE (1u << 8)
+#define FLASH_SECTOR_SIZE (1u << 12)
+
+inline uint8_t bm_host_flash[FLASH_SECTOR_SIZE];
+#define XIP_BASE ((uintptr_t)bm_host_flash)
+
+inline void flash_range_erase(uint32_t flash_offs, size_t count) {}
+inline void flash_range_program(uint32_t flash_offs, const uint8_t* data, size_t count) {}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "pico/stdlib.h"
+
+#define __isr
+
+typedef void (*irq_handler_t)();
+
+enum irq_num {
+    DMA_IRQ_0 = 10,
+    DMA_IRQ_1 = 11,
+};
+
+inline void irq_set_exclusive_handler(uint num, irq_handler_t handler) {}
+inline void irq_remove_handler(uint num, irq_handler_t handler) {}
+inline void irq_set_enabled(uint num, bool enabled) {}
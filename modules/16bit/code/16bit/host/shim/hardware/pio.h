@@ -0,0 +1,48 @@
+#pragma once
+
+// PIO stand-in. Words pushed to a state machine are dropped; host tools take
+// the rendered audio straight from the app instead of the I2S FIFO.
+
+#include "pico/stdlib.h"
+
+typedef struct pio_hw {
+    uint32_t txf[4];
+} pio_hw_t;
+
+typedef pio_hw_t* PIO;
+
+inline pio_hw_t bm_host_pio0;
+#define pio0 (&bm_host_pio0)
+
+typedef struct pio_program {
+    const uint16_t* instructions;
+    uint8_t length;
+    int8_t origin;
+} pio_program_t;
+
+typedef struct {
+    float clkdiv;
+} pio_sm_config;
+
+enum pio_fifo_join {
+    PIO_FIFO_JOIN_NONE = 0,
+    PIO_FIFO_JOIN_TX = 1,
+    PIO_FIFO_JOIN_RX = 2,
+};
+
+inline pio_sm_config pio_get_default_sm_config() {
+    return pio_sm_config{1.0f};
+}
+
+inline uint pio_add_program(PIO pio, const pio_program_t* program) { return 0; }
+inline void pio_sm_init(PIO pio, uint sm, uint initial_pc, const pio_sm_config* config) {}
+inline void pio_sm_set_enabled(PIO pio, uint sm, bool enabled) {}
+inline void pio_sm_put_blocking(PIO pio, uint sm, uint32_t data) { pio->txf[sm] = data; }
+inline void pio_gpio_init(PIO pio, uint pin) {}
+inline int pio_sm_set_consecutive_pindirs(PIO pio, uint sm, uint pin_base, uint pin_count, bool is_out) { return 0; }
+
+inline void sm_config_set_out_pins(pio_sm_config* c, uint out_base, uint out_count) {}
+inline void sm_config_set_out_shift(pio_sm_config* c, bool shift_right, bool autopull, uint pull_threshold) {}
+inline void sm_config_set_sideset_pins(pio_sm_config* c, uint sideset_base) {}
+inline void sm_config_set_fifo_join(pio_sm_config* c, pio_fifo_join join) {}
+inline void sm_config_set_clkdiv(pio_sm_config* c, float div) { c->clkdiv = div; }
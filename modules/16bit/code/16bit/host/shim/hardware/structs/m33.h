@@ -0,0 +1,27 @@
+#pragma once
+
+#include <stdint.h>
+#include <chrono>
+#include "hardware/clocks.h"
+
+#define M33_DEMCR_TRCENA_BITS 0x01000000u
+#define M33_DWT_CTRL_CYCCNTENA_BITS 0x00000001u
+
+// DWT cycle counter stand-in: host time scaled to the configured clk_sys,
+// so cycle budgets computed from clock_get_hz() stay meaningful.
+struct bm_host_cyccnt_t {
+    operator uint32_t() const {
+        auto now = std::chrono::steady_clock::now().time_since_epoch();
+        double seconds = std::chrono::duration<double>(now).count();
+        return (uint32_t)(uint64_t)(seconds * clock_get_hz(clk_sys));
+    }
+};
+
+typedef struct {
+    uint32_t demcr;
+    uint32_t dwt_ctrl;
+    bm_host_cyccnt_t dwt_cyccnt;
+} m33_hw_t;
+
+inline m33_hw_t bm_host_m33;
+#define m33_hw (&bm_host_m33)
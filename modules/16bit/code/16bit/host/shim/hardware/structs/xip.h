@@ -0,0 +1,19 @@
+#pragma once
+
+// PSRAM stand-in: an 8MB host buffer takes the place of the XIP M1 window.
+
+#include "pico/stdlib.h"
+
+#define XIP_CTRL_WRITABLE_M1_BITS 0x00000800u
+
+typedef struct {
+    uint32_t ctrl;
+} xip_ctrl_hw_t;
+
+inline xip_ctrl_hw_t bm_host_xip_ctrl;
+#define xip_ctrl_hw (&bm_host_xip_ctrl)
+
+#define BM_HOST_PSRAM_SIZE (8 * 1024 * 1024)
+alignas(16) inline uint8_t bm_host_psram[BM_HOST_PSRAM_SIZE];
+#define PSRAM_BASE_ADDR bm_host_psram
+#define PSRAM_SIZE BM_HOST_PSRAM_SIZE
@@ -0,0 +1,9 @@
+#pragma once
+
+#include "pico/stdlib.h"
+
+inline uint32_t save_and_disable_interrupts() { return 0; }
+inline void restore_interrupts(uint32_t status) {}
+inline void __wfe() {}
+inline void __sev() {}
+inline void __dmb() { __sync_synchronize(); }
@@ -0,0 +1,26 @@
+#pragma once
+
+// UART stand-in. Nothing is ever readable, so MIDI::update() is a no-op and
+// host tools deliver MIDI through the app callbacks directly.
+
+#include "pico/stdlib.h"
+
+typedef struct uart_inst uart_inst_t;
+
+#define uart0 ((uart_inst_t*)0)
+#define uart1 ((uart_inst_t*)1)
+
+enum uart_parity_t {
+    UART_PARITY_NONE,
+    UART_PARITY_EVEN,
+    UART_PARITY_ODD,
+};
+
+inline uint uart_init(uart_inst_t* uart, uint baudrate) { return baudrate; }
+inline void uart_set_format(uart_inst_t* uart, uint data_bits, uint stop_bits, uart_parity_t parity) {}
+inline void uart_set_hw_flow(uart_inst_t* uart, bool cts, bool rts) {}
+inline void uart_set_fifo_enabled(uart_inst_t* uart, bool enabled) {}
+inline bool uart_is_readable(uart_inst_t* uart) { return false; }
+inline bool uart_is_writable(uart_inst_t* uart) { return true; }
+inline char uart_getc(uart_inst_t* uart) { return 0; }
+inline void uart_putc(uart_inst_t* uart, char c) {}
@@ -0,0 +1,17 @@
+#pragma once
+
+// Host stand-in for the header pico_generate_pio_header() builds from i2s.pio.
+
+#include "hardware/pio.h"
+
+#define i2s_BCK_CYCLES 2
+
+static const pio_program_t i2s_program = {
+    .instructions = nullptr,
+    .length = 0,
+    .origin = -1,
+};
+
+static inline pio_sm_config i2s_program_get_default_config(uint offset) {
+    return pio_get_default_sm_config();
+}
@@ -0,0 +1,214 @@
+#pragma once
+
+// Host stand-in for littlefs.
+//
+// Implements the part of the littlefs API used by fs/pico_lfs.h on top of a
+// plain directory, so "/samples/01.raw" on the module is
+// "$BM_HOST_FS_ROOT/samples/01.raw" on the host (default root: ./host-fs).
+// The flash block device callbacks in lfs_config are kept but never called.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <string>
+#include <dirent.h>
+#include <sys/stat.h>
+
+typedef uint32_t lfs_size_t;
+typedef uint32_t lfs_off_t;
+typedef int32_t lfs_ssize_t;
+typedef int32_t lfs_soff_t;
+typedef uint32_t lfs_block_t;
+
+#define LFS_NAME_MAX 255
+
+enum lfs_error {
+    LFS_ERR_OK = 0,
+    LFS_ERR_IO = -5,
+    LFS_ERR_NOENT = -2,
+    LFS_ERR_EXIST = -17,
+    LFS_ERR_NOTDIR = -20,
+    LFS_ERR_ISDIR = -21,
+    LFS_ERR_INVAL = -22,
+    LFS_ERR_NOMEM = -12,
+};
+
+enum lfs_type {
+    LFS_TYPE_REG = 0x001,
+    LFS_TYPE_DIR = 0x002,
+};
+
+enum lfs_open_flags {
+    LFS_O_RDONLY = 1,
+    LFS_O_WRONLY = 2,
+    LFS_O_RDWR = 3,
+    LFS_O_CREAT = 0x0100,
+    LFS_O_EXCL = 0x0200,
+    LFS_O_TRUNC = 0x0400,
+    LFS_O_APPEND = 0x0800,
+};
+
+enum lfs_whence_flags {
+    LFS_SEEK_SET = 0,
+    LFS_SEEK_CUR = 1,
+    LFS_SEEK_END = 2,
+};
+
+struct lfs_config {
+    void* context;
+    int (*read)(const struct lfs_config* c, lfs_block_t block, lfs_off_t off, void* buffer, lfs_size_t size);
+    int (*prog)(const struct lfs_config* c, lfs_block_t block, lfs_off_t off, const void* buffer, lfs_size_t size);
+    int (*erase)(const struct lfs_config* c, lfs_block_t block);
+    int (*sync)(const struct lfs_config* c);
+    lfs_size_t read_size;
+    lfs_size_t prog_size;
+    lfs_size_t block_size;
+    lfs_size_t block_count;
+    int32_t block_cycles;
+    lfs_size_t cache_size;
+    lfs_size_t lookahead_size;
+};
+
+struct lfs_info {
+    uint8_t type;
+    lfs_size_t size;
+    char name[LFS_NAME_MAX + 1];
+};
+
+typedef struct lfs {
+    std::string root;
+} lfs_t;
+
+typedef struct lfs_file {
+    FILE* fp;
+} lfs_file_t;
+
+typedef struct lfs_dir {
+    DIR* dp;
+    std::string path;
+} lfs_dir_t;
+
+inline std::string bm_host_lfs_path(lfs_t* lfs, const char* path) {
+    return lfs->root + (path[0] == '/' ? "" : "/") + path;
+}
+
+inline int bm_host_lfs_errno() {
+    return errno == ENOENT ? LFS_ERR_NOENT : LFS_ERR_IO;
+}
+
+inline int lfs_format(lfs_t* lfs, const struct lfs_config* config) {
+    return 0;
+}
+
+inline int lfs_mount(lfs_t* lfs, const struct lfs_config* config) {
+    const char* root = getenv("BM_HOST_FS_ROOT");
+    lfs->root = root ? root : "host-fs";
+    if (mkdir(lfs->root.c_str(), 0755) != 0 && errno != EEXIST) {
+        return LFS_ERR_IO;
+    }
+    return 0;
+}
+
+inline int lfs_unmount(lfs_t* lfs) {
+    return 0;
+}
+
+inline int lfs_file_open(lfs_t* lfs, lfs_file_t* file, const char* path, int flags) {
+    std::string hostPath = bm_host_lfs_path(lfs, path);
+    const char* mode = "rb";
+    if ((flags & LFS_O_RDWR) == LFS_O_WRONLY || (flags & LFS_O_RDWR) == LFS_O_RDWR) {
+        if (flags & LFS_O_APPEND) {
+            mode = "ab";
+        } else if (flags & LFS_O_TRUNC) {
+            mode = "wb";
+        } else {
+            struct stat st;
+            bool exists = stat(hostPath.c_str(), &st) == 0;
+            if (!exists && !(flags & LFS_O_CREAT)) return LFS_ERR_NOENT;
+            mode = exists ? "r+b" : "w+b";
+        }
+    }
+
+    file->fp = fopen(hostPath.c_str(), mode);
+    return file->fp ? 0 : bm_host_lfs_errno();
+}
+
+inline int lfs_file_close(lfs_t* lfs, lfs_file_t* file) {
+    int err = fclose(file->fp);
+    file->fp = nullptr;
+    return err == 0 ? 0 : LFS_ERR_IO;
+}
+
+inline lfs_ssize_t lfs_file_read(lfs_t* lfs, lfs_file_t* file, void* buffer, lfs_size_t size) {
+    size_t n = fread(buffer, 1, size, file->fp);
+    return ferror(file->fp) ? LFS_ERR_IO : (lfs_ssize_t)n;
+}
+
+inline lfs_ssize_t lfs_file_write(lfs_t* lfs, lfs_file_t* file, const void* buffer, lfs_size_t size) {
+    size_t n = fwrite(buffer, 1, size, file->fp);
+    return n == size ? (lfs_ssize_t)n : LFS_ERR_IO;
+}
+
+inline lfs_soff_t lfs_file_seek(lfs_t* lfs, lfs_file_t* file, lfs_soff_t off, int whence) {
+    if (fseek(file->fp, off, whence) != 0) return LFS_ERR_INVAL;
+    return (lfs_soff_t)ftell(file->fp);
+}
+
+inline lfs_soff_t lfs_file_tell(lfs_t* lfs, lfs_file_t* file) {
+    return (lfs_soff_t)ftell(file->fp);
+}
+
+inline lfs_soff_t lfs_file_size(lfs_t* lfs, lfs_file_t* file) {
+    long pos = ftell(file->fp);
+    fseek(file->fp, 0, SEEK_END);
+    long size = ftell(file->fp);
+    fseek(file->fp, pos, SEEK_SET);
+    return (lfs_soff_t)size;
+}
+
+inline int lfs_remove(lfs_t* lfs, const char* path) {
+    return remove(bm_host_lfs_path(lfs, path).c_str()) == 0 ? 0 : bm_host_lfs_errno();
+}
+
+inline int lfs_mkdir(lfs_t* lfs, const char* path) {
+    if (mkdir(bm_host_lfs_path(lfs, path).c_str(), 0755) == 0) return 0;
+    return errno == EEXIST ? LFS_ERR_EXIST : bm_host_lfs_errno();
+}
+
+inline int lfs_stat(lfs_t* lfs, const char* path, struct lfs_info* info) {
+    struct stat st;
+    if (stat(bm_host_lfs_path(lfs, path).c_str(), &st) != 0) return bm_host_lfs_errno();
+    info->type = S_ISDIR(st.st_mode) ? LFS_TYPE_DIR : LFS_TYPE_REG;
+    info->size = (lfs_size_t)st.st_size;
+    const char* name = strrchr(path, '/');
+    snprintf(info->name, sizeof(info->name), "%s", name ? name + 1 : path);
+    return 0;
+}
+
+inline int lfs_dir_open(lfs_t* lfs, lfs_dir_t* dir, const char* path) {
+    dir->path = bm_host_lfs_path(lfs, path);
+    dir->dp = opendir(dir->path.c_str());
+    return dir->dp ? 0 : bm_host_lfs_errno();
+}
+
+inline int lfs_dir_close(lfs_t* lfs, lfs_dir_t* dir) {
+    closedir(dir->dp);
+    dir->dp = nullptr;
+    return 0;
+}
+
+// Returns 1 for an entry, 0 at the end of the directory
+inline int lfs_dir_read(lfs_t* lfs, lfs_dir_t* dir, struct lfs_info* info) {
+    struct dirent* entry = readdir(dir->dp);
+    if (!entry) return 0;
+
+    struct stat st;
+    std::string entryPath = dir->path + "/" + entry->d_name;
+    stat(entryPath.c_str(), &st);
+    info->type = S_ISDIR(st.st_mode) ? LFS_TYPE_DIR : LFS_TYPE_REG;
+    info->size = (lfs_size_t)st.st_size;
+    snprintf(info->name, sizeof(info->name), "%s", entry->d_name);
+    return 1;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+// There is no second core on the host. Launching core1 only records the entry
+// point; host tools drive the audio path themselves, block by block.
+
+#include "pico/stdlib.h"
+
+inline void (*bm_host_core1_entry)() = nullptr;
+
+inline void multicore_launch_core1(void (*entry)()) {
+    bm_host_core1_entry = entry;
+}
+
+inline void multicore_reset_core1() {
+    bm_host_core1_entry = nullptr;
+}
+
+// Nothing runs on a second core, so there is nothing to park during flash
+// writes
+inline void multicore_lockout_victim_init() {}
+
+inline bool multicore_lockout_start_timeout_us(uint64_t timeout_us) {
+    return true;
+}
+
+inline void multicore_lockout_end_blocking() {}
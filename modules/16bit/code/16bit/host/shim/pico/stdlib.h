@@ -0,0 +1,97 @@
+#pragma once
+
+// Host stand-in for the Pico SDK's pico/stdlib.h.
+// Only the subset used by the 16bit firmware is provided. Time comes from the
+// host's steady clock and GPIO writes are kept in memory so tools can inspect them.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include "pico/sync.h"
+
+typedef unsigned int uint;
+typedef uint64_t absolute_time_t;
+
+#ifndef MIN
+#define MIN(a, b) ((b) < (a) ? (b) : (a))
+#endif
+
+#ifndef MAX
+#define MAX(a, b) ((a) < (b) ? (b) : (a))
+#endif
+
+#define PICO_ERROR_TIMEOUT -1
+
+#ifndef PICO_PROGRAM_VERSION_STRING
+#define PICO_PROGRAM_VERSION_STRING "host"
+#endif
+
+#define GPIO_IN false
+#define GPIO_OUT true
+
+enum gpio_function {
+    GPIO_FUNC_XIP_CS1 = 0,
+    GPIO_FUNC_UART = 2,
+    GPIO_FUNC_PIO0 = 6,
+};
+
+inline uint64_t bm_host_time_us() {
+    static const auto start = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+inline absolute_time_t get_absolute_time() {
+    return bm_host_time_us();
+}
+
+inline int64_t absolute_time_diff_us(absolute_time_t from, absolute_time_t to) {
+    return (int64_t)(to - from);
+}
+
+inline absolute_time_t delayed_by_us(absolute_time_t t, uint64_t us) {
+    return t + us;
+}
+
+inline uint32_t to_ms_since_boot(absolute_time_t t) {
+    return (uint32_t)(t / 1000);
+}
+
+inline uint32_t time_us_32() {
+    return (uint32_t)bm_host_time_us();
+}
+
+inline uint64_t time_us_64() {
+    return bm_host_time_us();
+}
+
+inline void sleep_us(uint64_t us) {}
+inline void sleep_ms(uint32_t ms) {}
+inline void sleep_until(absolute_time_t t) {}
+inline void tight_loop_contents() {}
+
+// Host tools run the audio path and everything else on one thread, so
+// nothing can race the audio core: report it, and code that keeps state
+// for the audio core (like the BiquadCache) takes the same path as there
+inline uint get_core_num() { return 1; }
+
+inline bool stdio_init_all() {
+    return true;
+}
+
+inline int getchar_timeout_us(uint32_t timeout_us) {
+    return PICO_ERROR_TIMEOUT;
+}
+
+// GPIO state lives in memory; nothing is driven on the host
+inline bool bm_host_gpio[48];
+
+inline void gpio_init(uint gpio) {}
+inline void gpio_set_dir(uint gpio, bool out) {}
+inline void gpio_pull_up(uint gpio) { bm_host_gpio[gpio] = true; }
+inline void gpio_set_function(uint gpio, gpio_function fn) {}
+inline void gpio_put(uint gpio, bool value) { bm_host_gpio[gpio] = value; }
+inline bool gpio_get(uint gpio) { return bm_host_gpio[gpio]; }
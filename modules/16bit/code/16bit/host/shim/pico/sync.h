@@ -0,0 +1,27 @@
+#pragma once
+
+// Critical sections map onto a recursive mutex, so host tools can still run
+// the control and audio paths on separate threads if they want to.
+
+#include <mutex>
+
+typedef struct {
+    std::recursive_mutex* mutex;
+} critical_section_t;
+
+inline void critical_section_init(critical_section_t* cs) {
+    cs->mutex = new std::recursive_mutex();
+}
+
+inline void critical_section_enter_blocking(critical_section_t* cs) {
+    cs->mutex->lock();
+}
+
+inline void critical_section_exit(critical_section_t* cs) {
+    cs->mutex->unlock();
+}
+
+inline void critical_section_deinit(critical_section_t* cs) {
+    delete cs->mutex;
+    cs->mutex = nullptr;
+}
@@ -0,0 +1,248 @@
+#pragma once
+
+// Standard MIDI File (format 0 and 1) reader for the host tools.
+// All tracks are merged and converted from ticks to absolute sample frames
+// through the file's tempo map, so events can be dispatched sample-accurately.
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+#define SMF_DEFAULT_TEMPO_US 500000 // 120 BPM until the first tempo event
+
+enum SmfEventType : uint8_t {
+    SMF_NOTE_OFF,
+    SMF_NOTE_ON,
+    SMF_CONTROL_CHANGE,
+    SMF_PITCH_BEND,
+    SMF_TEMPO,
+};
+
+struct SmfEvent {
+    uint64_t frame;
+    SmfEventType type;
+    uint8_t channel;
+    uint8_t data1;
+    uint8_t data2;
+    uint32_t tempo; // microseconds per quarter note, SMF_TEMPO only
+};
+
+struct SmfTrackEvent {
+    uint64_t tick;
+    SmfEvent event;
+};
+
+class SmfReader {
+private:
+    const std::vector<uint8_t>& bytes;
+    size_t pos;
+    size_t end;
+
+public:
+    SmfReader(const std::vector<uint8_t>& bytes, size_t pos, size_t end) : bytes(bytes), pos(pos), end(end) {}
+
+    bool done() const {
+        return pos >= end;
+    }
+
+    uint8_t peek() const {
+        return pos < end ? bytes[pos] : 0;
+    }
+
+    uint8_t byte() {
+        return pos < end ? bytes[pos++] : 0;
+    }
+
+    uint32_t varLen() {
+        uint32_t value = 0;
+        for (int i = 0; i < 4; i++) {
+            uint8_t b = byte();
+            value = (value << 7) | (b & 0x7F);
+            if ((b & 0x80) == 0) break;
+        }
+        return value;
+    }
+
+    void skip(uint32_t count) {
+        pos = std::min(end, pos + count);
+    }
+};
+
+static inline uint32_t smfReadBE(const std::vector<uint8_t>& bytes, size_t pos, int count) {
+    uint32_t value = 0;
+    for (int i = 0; i < count; i++) {
+        value = (value << 8) | bytes[pos + i];
+    }
+    return value;
+}
+
+// Parses one MTrk chunk into `out`. Sysex and meta events other than tempo
+// are skipped.
+inline void smfParseTrack(const std::vector<uint8_t>& bytes, size_t start, size_t end, std::vector<SmfTrackEvent>& out) {
+    SmfReader reader(bytes, start, end);
+    uint64_t tick = 0;
+    uint8_t status = 0;
+
+    while (!reader.done()) {
+        tick += reader.varLen();
+
+        uint8_t b = reader.peek();
+        if (b & 0x80) {
+            reader.byte();
+            if (b < 0xF0) {
+                status = b; // running status only applies to channel messages
+            }
+        } else {
+            b = status;
+        }
+
+        if (b == 0xFF) {
+            uint8_t meta = reader.byte();
+            uint32_t length = reader.varLen();
+            if (meta == 0x2F) {
+                break;
+            }
+            if (meta == 0x51 && length == 3) {
+                SmfEvent event = {};
+                event.type = SMF_TEMPO;
+                event.tempo = reader.byte() << 16;
+                event.tempo |= reader.byte() << 8;
+                event.tempo |= reader.byte();
+                out.push_back({tick, event});
+            } else {
+                reader.skip(length);
+            }
+            continue;
+        }
+
+        if (b == 0xF0 || b == 0xF7) {
+            reader.skip(reader.varLen());
+            continue;
+        }
+
+        if (b < 0x80) {
+            // Data byte without any status: corrupt track, stop here
+            break;
+        }
+
+        uint8_t type = b & 0xF0;
+        SmfEvent event = {};
+        event.channel = b & 0x0F;
+        event.data1 = reader.byte();
+        if (type != 0xC0 && type != 0xD0) {
+            event.data2 = reader.byte();
+        }
+
+        switch (type) {
+            case 0x80:
+                event.type = SMF_NOTE_OFF;
+                break;
+            case 0x90:
+                event.type = event.data2 == 0 ? SMF_NOTE_OFF : SMF_NOTE_ON;
+                break;
+            case 0xB0:
+                event.type = SMF_CONTROL_CHANGE;
+                break;
+            case 0xE0:
+                event.type = SMF_PITCH_BEND;
+                break;
+            default:
+                continue; // program change, aftertouch: nothing to feed the apps
+        }
+
+        out.push_back({tick, event});
+    }
+}
+
+// Loads `path` and returns its events in playback order, timestamped in
+// frames at `sampleRate`. Returns false (and prints why) on failure.
+inline bool loadSmf(const char* path, uint32_t sampleRate, std::vector<SmfEvent>& events) {
+    FILE* file = fopen(path, "rb");
+    if (file == nullptr) {
+        printf("Failed to open MIDI file: %s\n", path);
+        return false;
+    }
+
+    std::vector<uint8_t> bytes;
+    uint8_t chunk[4096];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        bytes.insert(bytes.end(), chunk, chunk + n);
+    }
+    fclose(file);
+
+    if (bytes.size() < 14 || memcmp(&bytes[0], "MThd", 4) != 0) {
+        printf("Not a Standard MIDI File: %s\n", path);
+        return false;
+    }
+
+    uint32_t headerSize = smfReadBE(bytes, 4, 4);
+    uint16_t format = smfReadBE(bytes, 8, 2);
+    uint16_t division = smfReadBE(bytes, 12, 2);
+    if (format > 1) {
+        printf("Unsupported SMF format %d (only 0 and 1): %s\n", format, path);
+        return false;
+    }
+
+    std::vector<SmfTrackEvent> trackEvents;
+    size_t pos = 8 + headerSize;
+    while (pos + 8 <= bytes.size()) {
+        uint32_t size = smfReadBE(bytes, pos + 4, 4);
+        size_t body = pos + 8;
+        size_t end = std::min(bytes.size(), body + size);
+        if (memcmp(&bytes[pos], "MTrk", 4) == 0) {
+            smfParseTrack(bytes, body, end, trackEvents);
+        }
+        pos = end;
+    }
+
+    // Merge the tracks. The sort is stable so same-tick events (e.g. a
+    // note-off before a note-on on the same key) stay in file order.
+    std::stable_sort(trackEvents.begin(), trackEvents.end(), [](const SmfTrackEvent& a, const SmfTrackEvent& b) {
+        return a.tick < b.tick;
+    });
+
+    // Walk the tempo map, accumulating time one tempo segment at a time
+    double ticksPerSecond = 0.0;
+    double usPerQuarter = SMF_DEFAULT_TEMPO_US;
+    bool smpte = division & 0x8000;
+    if (smpte) {
+        int fps = -(int8_t)(division >> 8);
+        ticksPerSecond = (double)fps * (division & 0xFF);
+    }
+    uint16_t ticksPerQuarter = smpte ? 1 : division;
+    if (smpte ? ticksPerSecond <= 0.0 : ticksPerQuarter == 0) {
+        printf("Invalid SMF division: %s\n", path);
+        return false;
+    }
+
+    double seconds = 0.0;
+    uint64_t lastTick = 0;
+    events.clear();
+    events.reserve(trackEvents.size());
+
+    for (SmfTrackEvent& trackEvent : trackEvents) {
+        uint64_t delta = trackEvent.tick - lastTick;
+        if (smpte) {
+            seconds += delta / ticksPerSecond;
+        } else {
+            seconds += delta * usPerQuarter / ticksPerQuarter / 1000000.0;
+        }
+        lastTick = trackEvent.tick;
+
+        if (trackEvent.event.type == SMF_TEMPO) {
+            if (trackEvent.event.tempo == 0) {
+                // A zero tempo is malformed: keep the old one and don't pass it on
+                continue;
+            }
+            usPerQuarter = trackEvent.event.tempo;
+        }
+
+        trackEvent.event.frame = (uint64_t)(seconds * sampleRate + 0.5);
+        events.push_back(trackEvent.event);
+    }
+
+    return true;
+}
@@ -0,0 +1,200 @@
+#pragma once
+
+// Minimal WAV reader/writer for the host tools.
+// Reads 16/24/32-bit PCM and 32-bit float, mono or stereo. Writes stereo
+// 16-bit PCM (what the PT8211 DAC gets) or 32-bit float (for null tests).
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+struct WavData {
+    uint32_t sampleRate = 0;
+    std::vector<float> left;
+    std::vector<float> right;
+
+    size_t frames() const {
+        return left.size();
+    }
+};
+
+static inline uint16_t wavRead16(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline uint32_t wavRead32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline float wavDecodeSample(const uint8_t* p, uint16_t format, uint16_t bits) {
+    if (format == 3) {
+        float value;
+        memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    switch (bits) {
+        case 16:
+            return (int16_t)wavRead16(p) / 32768.0f;
+        case 24:
+            return (int32_t)(((uint32_t)p[0] << 8) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 24)) / 2147483648.0f;
+        default:
+            return (int32_t)wavRead32(p) / 2147483648.0f;
+    }
+}
+
+// Mono files are copied to both channels. Returns false (and prints why) if
+// the file can't be read or uses an unsupported encoding.
+inline bool readWav(const char* path, WavData& wav) {
+    FILE* file = fopen(path, "rb");
+    if (file == nullptr) {
+        printf("Failed to open WAV: %s\n", path);
+        return false;
+    }
+
+    std::vector<uint8_t> bytes;
+    uint8_t chunk[4096];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        bytes.insert(bytes.end(), chunk, chunk + n);
+    }
+    fclose(file);
+
+    if (bytes.size() < 12 || memcmp(&bytes[0], "RIFF", 4) != 0 || memcmp(&bytes[8], "WAVE", 4) != 0) {
+        printf("Not a WAV file: %s\n", path);
+        return false;
+    }
+
+    uint16_t format = 0, channels = 0, bits = 0;
+    const uint8_t* data = nullptr;
+    uint32_t dataSize = 0;
+
+    size_t pos = 12;
+    while (pos + 8 <= bytes.size()) {
+        const uint8_t* id = &bytes[pos];
+        uint32_t size = wavRead32(&bytes[pos + 4]);
+        size_t body = pos + 8;
+        if (size > bytes.size() - body) {
+            size = (uint32_t)(bytes.size() - body);
+        }
+
+        if (memcmp(id, "fmt ", 4) == 0 && size >= 16) {
+            format = wavRead16(&bytes[body]);
+            channels = wavRead16(&bytes[body + 2]);
+            wav.sampleRate = wavRead32(&bytes[body + 4]);
+            bits = wavRead16(&bytes[body + 14]);
+            // WAVE_FORMAT_EXTENSIBLE: the real format is in the sub-format GUID
+            if (format == 0xFFFE && size >= 26) {
+                format = wavRead16(&bytes[body + 24]);
+            }
+        } else if (memcmp(id, "data", 4) == 0) {
+            data = &bytes[body];
+            dataSize = size;
+        }
+
+        pos = body + size + (size & 1);
+    }
+
+    bool supported = (format == 1 && (bits == 16 || bits == 24 || bits == 32)) || (format == 3 && bits == 32);
+    if (data == nullptr || channels == 0 || !supported) {
+        printf("Unsupported WAV (format %d, %d bits, %d channels): %s\n", format, bits, channels, path);
+        return false;
+    }
+
+    size_t bytesPerSample = bits / 8;
+    size_t frameSize = bytesPerSample * channels;
+    size_t frames = dataSize / frameSize;
+
+    wav.left.resize(frames);
+    wav.right.resize(frames);
+    for (size_t i = 0; i < frames; i++) {
+        const uint8_t* frame = data + i * frameSize;
+        wav.left[i] = wavDecodeSample(frame, format, bits);
+        wav.right[i] = channels > 1 ? wavDecodeSample(frame + bytesPerSample, format, bits) : wav.left[i];
+    }
+
+    return true;
+}
+
+// Streams stereo frames to disk; the header sizes are patched in close()
+class WavWriter {
+private:
+    FILE* file = nullptr;
+    bool asFloat = false;
+    uint32_t sampleRate = 0;
+    uint32_t frames = 0;
+
+    void write16(uint16_t value) {
+        uint8_t b[2] = {(uint8_t)value, (uint8_t)(value >> 8)};
+        fwrite(b, 1, 2, file);
+    }
+
+    void write32(uint32_t value) {
+        uint8_t b[4] = {(uint8_t)value, (uint8_t)(value >> 8), (uint8_t)(value >> 16), (uint8_t)(value >> 24)};
+        fwrite(b, 1, 4, file);
+    }
+
+    void writeHeader() {
+        uint16_t bytesPerSample = asFloat ? 4 : 2;
+        uint32_t dataSize = frames * 2 * bytesPerSample;
+
+        fwrite("RIFF", 1, 4, file);
+        write32(36 + dataSize);
+        fwrite("WAVEfmt ", 1, 8, file);
+        write32(16);
+        write16(asFloat ? 3 : 1);
+        write16(2);
+        write32(sampleRate);
+        write32(sampleRate * 2 * bytesPerSample);
+        write16(2 * bytesPerSample);
+        write16(bytesPerSample * 8);
+        fwrite("data", 1, 4, file);
+        write32(dataSize);
+    }
+
+public:
+    ~WavWriter() {
+        close();
+    }
+
+    bool open(const char* path, uint32_t rate, bool writeFloat) {
+        file = fopen(path, "wb");
+        if (file == nullptr) {
+            printf("Failed to create WAV: %s\n", path);
+            return false;
+        }
+
+        sampleRate = rate;
+        asFloat = writeFloat;
+        frames = 0;
+        writeHeader();
+        return true;
+    }
+
+    // 16-bit output is clamped and quantised the same way as AudioManager::packBlock
+    void write(const float* left, const float* right, size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            if (asFloat) {
+                fwrite(&left[i], sizeof(float), 1, file);
+                fwrite(&right[i], sizeof(float), 1, file);
+            } else {
+                write16((uint16_t)(int16_t)std::clamp(left[i] * 32768.0f, -32768.0f, 32767.0f));
+                write16((uint16_t)(int16_t)std::clamp(right[i] * 32768.0f, -32768.0f, 32767.0f));
+            }
+        }
+        frames += (uint32_t)count;
+    }
+
+    void close() {
+        if (file == nullptr) {
+            return;
+        }
+
+        fseek(file, 0, SEEK_SET);
+        writeHeader();
+        fclose(file);
+        file = nullptr;
+    }
+};
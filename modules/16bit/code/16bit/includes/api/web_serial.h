@@ -108,7 +108,10 @@ class WebSerial {
             commandBufferPos = 0;
             encodedPos = 0;
 
-            allocateMemory();
+            if (!allocateMemory()) {
+                resetTransferState();
+                return false;
+            }
             audioManager->stop();
             return true;
         }
@@ -178,7 +181,12 @@ class WebSerial {
         size_t encodedPos = 0;
         AudioManager* audioManager = AudioManager::getInstance();
 
+        // Also gives the transfer buffers back to PSRAM
         void resetTransferState() {
+            psram->free(encodedBuffer);
+            psram->free(decodedBuffer);
+            encodedBuffer = nullptr;
+            decodedBuffer = nullptr;
             transferMode = false;
             currentTransferSize = 0;
             totalBytesTransferred = 0;
@@ -188,10 +196,12 @@ class WebSerial {
             encodedPos = 0;
         }
 
-        void allocateMemory() {
-            volatile uint8_t* base = psram->alloc(WEB_SERIAL_BUFFER_SIZE);
+        // Only held for the length of a transfer
+        bool allocateMemory() {
+            volatile uint8_t* base = psram->alloc(WEB_SERIAL_BUFFER_SIZE, PSRAM_ARENA_TRANSFER);
             encodedBuffer = (char*)base;
-            decodedBuffer = (uint8_t*)psram->alloc(WEB_SERIAL_BUFFER_SIZE);
+            decodedBuffer = (uint8_t*)psram->alloc(WEB_SERIAL_BUFFER_SIZE, PSRAM_ARENA_TRANSFER);
+            return encodedBuffer != nullptr && decodedBuffer != nullptr;
         }
 
         void decodeBase64Data() {
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <stdint.h>
+#include "pico/stdlib.h"
+#include "hardware/adc.h"
+#include "hardware/dma.h"
+
+// Free-running capture of all four ADC inputs.
+// The ADC samples A0, A1, CV1 and CV2 in round-robin at 4x the audio rate and
+// DMA streams the results into a ring buffer, so nobody ever blocks on
+// adc_read(). The audio core pulls its inputs out of the ring a block at a
+// time; CVs are read as the average of the most recent frames.
+//
+// A data channel fills the ring once, then chains to a control channel that
+// re-arms it at the start of the ring. The ADC keeps converting meanwhile
+// (its FIFO covers the re-arm), so frames stay channel-aligned.
+
+#define ADC_CHANNEL_A0 0
+#define ADC_CHANNEL_A1 1
+#define ADC_CHANNEL_CV1 2
+#define ADC_CHANNEL_CV2 3
+#define ADC_CAPTURE_CHANNELS 4
+
+// Ring size in frames (one sample of each channel). Needs to hold a few
+// audio blocks so the reader has room to track the DMA.
+#define ADC_CAPTURE_FRAMES 256
+
+// CVs are averaged over this many frames (~1.5ms at 44.1kHz): a boxcar
+// decimation filter that knocks down ADC noise before the change threshold.
+#define ADC_CV_AVERAGE_FRAMES 64
+
+static_assert(ADC_CAPTURE_FRAMES >= 4 * 64, "ADC ring must hold at least 4 of the largest audio blocks");
+
+class AdcCapture;
+AdcCapture* adc_capture_instance = nullptr;
+
+class AdcCapture {
+private:
+    uint16_t ring[ADC_CAPTURE_FRAMES * ADC_CAPTURE_CHANNELS] __attribute__((aligned(8)));
+    // The control channel copies this into the data channel's write address
+    uint16_t* ringStart = ring;
+    int dataChannel = -1;
+    int controlChannel = -1;
+    bool running = false;
+
+    // Audio reader position in frames (core1 only)
+    uint32_t readFrame = 0;
+
+    AdcCapture() {}
+
+    // Index of the next frame the DMA will complete. A partially written
+    // frame isn't counted, so everything before it is safe to read.
+    uint32_t writeFrame() const {
+        uint32_t address = dma_channel_hw_addr(dataChannel)->write_addr;
+        uint32_t sample = (address - (uint32_t)(uintptr_t)ring) / sizeof(uint16_t);
+        return (sample / ADC_CAPTURE_CHANNELS) % ADC_CAPTURE_FRAMES;
+    }
+
+public:
+    static AdcCapture* getInstance() {
+        if (adc_capture_instance == nullptr) {
+            adc_capture_instance = new AdcCapture();
+        }
+        return adc_capture_instance;
+    }
+
+    void init(uint32_t sampleRate) {
+        if (running) {
+            return;
+        }
+
+        for (uint32_t i = 0; i < ADC_CAPTURE_FRAMES * ADC_CAPTURE_CHANNELS; i++) {
+            ring[i] = 2048;
+        }
+
+        adc_init();
+        adc_gpio_init(26 + ADC_CHANNEL_A0);
+        adc_gpio_init(26 + ADC_CHANNEL_A1);
+        adc_gpio_init(26 + ADC_CHANNEL_CV1);
+        adc_gpio_init(26 + ADC_CHANNEL_CV2);
+
+        adc_select_input(ADC_CHANNEL_A0);
+        adc_set_round_robin((1u << ADC_CAPTURE_CHANNELS) - 1);
+        // One conversion every (1 + div) cycles of the 48MHz ADC clock
+        adc_set_clkdiv(48000000.0f / (sampleRate * ADC_CAPTURE_CHANNELS) - 1.0f);
+        adc_fifo_setup(true, true, 1, false, false);
+        adc_fifo_drain();
+
+        dataChannel = dma_claim_unused_channel(true);
+        controlChannel = dma_claim_unused_channel(true);
+
+        dma_channel_config data = dma_channel_get_default_config(dataChannel);
+        channel_config_set_transfer_data_size(&data, DMA_SIZE_16);
+        channel_config_set_read_increment(&data, false);
+        channel_config_set_write_increment(&data, true);
+        channel_config_set_dreq(&data, DREQ_ADC);
+        channel_config_set_chain_to(&data, controlChannel);
+        dma_channel_configure(dataChannel, &data, ring, &adc_hw->fifo,
+                              ADC_CAPTURE_FRAMES * ADC_CAPTURE_CHANNELS, false);
+
+        dma_channel_config control = dma_channel_get_default_config(controlChannel);
+        channel_config_set_transfer_data_size(&control, DMA_SIZE_32);
+        channel_config_set_read_increment(&control, false);
+        channel_config_set_write_increment(&control, false);
+        dma_channel_configure(controlChannel, &control, &dma_channel_hw_addr(dataChannel)->al2_write_addr_trig,
+                              &ringStart, 1, false);
+
+        dma_channel_start(dataChannel);
+        adc_run(true);
+        running = true;
+    }
+
+    bool isRunning() const {
+        return running;
+    }
+
+    // Copy the next `frames` audio-in frames (A0 -> left, A1 -> right) to
+    // `left`/`right` as -1..1. Runs once per block on the audio core; if the
+    // reader drifts too close to or too far from the DMA (the ADC and DAC
+    // clocks are not locked), it jumps back to two blocks of latency.
+    template <typename Frame>
+    void readAudio(Frame* output, size_t frames) {
+        uint32_t write = writeFrame();
+        uint32_t available = (write - readFrame) % ADC_CAPTURE_FRAMES;
+        if (available < frames || available > 3 * frames) {
+            readFrame = (write + ADC_CAPTURE_FRAMES - 2 * frames) % ADC_CAPTURE_FRAMES;
+        }
+
+        for (size_t n = 0; n < frames; n++) {
+            const uint16_t* frame = &ring[readFrame * ADC_CAPTURE_CHANNELS];
+            output[n].left = ((int16_t)frame[ADC_CHANNEL_A0] - 2048) / 2048.0f;
+            output[n].right = ((int16_t)frame[ADC_CHANNEL_A1] - 2048) / 2048.0f;
+            readFrame = (readFrame + 1) % ADC_CAPTURE_FRAMES;
+        }
+    }
+
+    // Averaged 12-bit reading of an ADC channel over the latest frames
+    uint16_t readAveraged(uint8_t channel) const {
+        uint32_t frame = writeFrame();
+        uint32_t sum = 0;
+        for (uint32_t i = 0; i < ADC_CV_AVERAGE_FRAMES; i++) {
+            frame = (frame + ADC_CAPTURE_FRAMES - 1) % ADC_CAPTURE_FRAMES;
+            sum += ring[frame * ADC_CAPTURE_CHANNELS + channel];
+        }
+        return (sum + ADC_CV_AVERAGE_FRAMES / 2) / ADC_CV_AVERAGE_FRAMES;
+    }
+
+    uint16_t readCV1() const {
+        return readAveraged(ADC_CHANNEL_CV1);
+    }
+
+    uint16_t readCV2() const {
+        return readAveraged(ADC_CHANNEL_CV2);
+    }
+};
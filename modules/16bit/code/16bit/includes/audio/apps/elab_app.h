@@ -6,6 +6,7 @@
 #include "audio/manager.h"
 #include "audio/apps/interfaces/audio_app.h"
 #include "audio/gen/Saw.h"
+#include "audio/tools/fastmath.h"
 #include "fs/config.h"
 
 class ElabApp : public AudioApp {
@@ -35,13 +36,14 @@ private:
 
 public:
     void init() override;
-    void audioCallback(AudioInput *input, AudioOutput *output) override;
+    void processBlock(const AudioInput* input, AudioOutput* output, size_t frames) override;
     void update() override;
 
     // MIDI callback methods
     void noteOnCallback(uint8_t channel, uint8_t note, uint8_t velocity) override;
     void noteOffCallback(uint8_t channel, uint8_t note, uint8_t velocity) override;
     void ccChangeCallback(uint8_t channel, uint8_t cc, uint8_t value) override;
+    void pitchBendCallback(uint8_t channel, int16_t bend) override;
     void bpmChangeCallback(int bpm) override;
 
     // Knobs and buttons
@@ -2,11 +2,12 @@
 
 #include "audio/apps/interfaces/audio_fx.h"
 #include "audio/mod/Delay.h"
+#include "audio/tools/fastmath.h"
 
 class DelayFX : public AudioFX {
 
 private:
-    Delay delay{1000};
+    Delay delay{1000, DELAY_STORAGE_INT16};
     float parameterValues[4];
 
 public:
@@ -35,12 +36,18 @@ public:
 
     virtual void init(AudioManager* audioManager) override {
         delay.init(audioManager);
-        delay.setFilterType(Biquad::HIGHPASS);
+        delay.setFilterType(BIQUAD_HIGHPASS);
     }
 
     virtual float process(float input) override {
         return delay.process(input);
     }
+
+    virtual void processBlock(float* left, float* right, size_t frames) override {
+        foldToMono(left, right, frames);
+        delay.processBlock(left, frames);
+        spreadMono(left, right, frames);
+    }
     
     virtual void setBPM(uint16_t bpm) override {
         delay.setBPM(bpm);
@@ -63,12 +70,12 @@ public:
             case 2: delay.setWet(value); break;
             case 3: {
                 if (value <= 0.0f) {
-                    delay.setFilterType(Biquad::LOWPASS);
+                    delay.setFilterType(BIQUAD_LOWPASS);
                     delay.setLowpassCutoff(20000.0f);
                     delay.setResonance(0.7f);
                 } else {
-                    delay.setFilterType(Biquad::HIGHPASS);
-                    float cutoff = 100.0f * powf(20000.0f / 100.0f, value * value);
+                    delay.setFilterType(BIQUAD_HIGHPASS);
+                    float cutoff = expRange(100.0f, 20000.0f, value * value);
                     delay.setLowpassCutoff(cutoff);
                     if (cutoff <= 500.0f) {
                         delay.setResonance(0.7f);
@@ -2,17 +2,15 @@
 
 #include "audio/apps/interfaces/audio_fx.h"
 #include "audio/mod/Ladder.h"
+#include "audio/mod/Modulation.h"
 
 class FilterFX : public AudioFX {
     private:
         Ladder filter{Ladder::FilterType::LOWPASS};
         float cutoff = 20000.0f;
-        // Envelope state for cutoff modulation
-        float envelope = 0.0f;
-        float envTarget = 0.0f;
-        float attack = 0.01f;  // seconds (default)
-        float release = 0.1f;  // seconds (default)
-        float sampleRate = 48000.0f;
+        // Cutoff modulation, updated at control rate
+        GateEnvelope envelope;
+        ControlClock controlClock;
         float modAmount = 10000.0f; // Fixed modulation amount in Hz
 
 public:
@@ -40,42 +38,50 @@ public:
 
     virtual void init(AudioManager* audioManager) override {
         filter.init(audioManager);
-        sampleRate = audioManager->getDac()->getSampleRate();
+        envelope.init(audioManager);
     }
 
     virtual float process(float input) override {
-        // Envelope update
-        float rate;
-        if (envTarget > envelope) {
-            // Attack phase
-            rate = 1.0f - expf(-1.0f / (attack * sampleRate + 1e-6f));
-        } else {
-            // Release phase
-            rate = 1.0f - expf(-1.0f / (release * sampleRate + 1e-6f));
+        // Modulate cutoff; the ladder ramps to it between ticks
+        if (controlClock.tick()) {
+            filter.setCutoff(cutoff + envelope.tick() * modAmount);
         }
-        envelope += (envTarget - envelope) * rate;
-
-        // Modulate cutoff
-        float modulatedCutoff = cutoff + envelope * modAmount;
-        filter.setCutoff(modulatedCutoff);
         return filter.process(input);
     }
 
+    virtual void processBlock(float* left, float* right, size_t frames) override {
+        foldToMono(left, right, frames);
+
+        // Filter a run at a time, setting the cutoff where a control tick
+        // falls, as process() would
+        size_t start = 0;
+        for (size_t n = 0; n < frames; n++) {
+            if (controlClock.tick()) {
+                filter.processBlock(left + start, n - start);
+                start = n;
+                filter.setCutoff(cutoff + envelope.tick() * modAmount);
+            }
+        }
+        filter.processBlock(left + start, frames - start);
+
+        spreadMono(left, right, frames);
+    }
+
     virtual void setBPM(uint16_t bpm) override {
         
     }
 
     virtual void setGate(bool gate) override {
         // this is gate on and off
-        envTarget = gate ? 1.0f : 0.0f;
+        envelope.setGate(gate);
     }
 
     virtual void setParameter(uint8_t parameter, float value) override {
         switch (parameter) {
             case 0:
                 // attack & release (value is 0.0 to 1.0)
-                attack = 0.005f + value * 0.1f; // 5ms to 2s
-                release = attack;
+                envelope.setAttack(0.005f + value * 0.1f); // 5ms to 2s
+                envelope.setRelease(0.005f + value * 0.1f);
                 break;
             case 1:
                 // modulation amount (value is 0.0 to 1.0)
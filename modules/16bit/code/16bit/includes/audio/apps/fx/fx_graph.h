@@ -0,0 +1,265 @@
+#pragma once
+
+#include <string.h>
+#include "audio/manager.h"
+#include "audio/apps/fx/fx_slot.h"
+
+#define FX_GRAPH_SLOTS 3
+
+// What feeds a slot. The input split (left/right/mid/side/stereo) or the
+// output of an earlier slot, for serial chains; slots sharing a source run
+// in parallel.
+enum FXRouteSource {
+    FX_SOURCE_LEFT,   // Left input on both channels
+    FX_SOURCE_RIGHT,  // Right input on both channels
+    FX_SOURCE_MID,    // (L + R) / 2 on both channels
+    FX_SOURCE_SIDE,   // (L - R) / 2 on both channels
+    FX_SOURCE_STEREO, // Left and right as they are
+    FX_SOURCE_SLOT1,
+    FX_SOURCE_SLOT2,
+    FX_SOURCE_COUNT,
+};
+
+// Where a slot returns to
+enum FXRouteOutput {
+    FX_OUTPUT_NONE,   // Only feeds later slots
+    FX_OUTPUT_LEFT,   // Its left channel to the left output
+    FX_OUTPUT_RIGHT,  // Its right channel to the right output
+    FX_OUTPUT_STEREO, // Left to left, right to right
+    FX_OUTPUT_SIDE,   // Left to left, right inverted to right: decodes a side slot next to a mid one
+    FX_OUTPUT_COUNT,
+};
+
+// One slot's edges. Levels are in percent, so a route fits in Config bytes.
+typedef struct {
+    uint8_t source; // FXRouteSource
+    uint8_t send;   // Into the effect
+    uint8_t wet;    // Effect vs the unprocessed send, on the way out
+    uint8_t output; // FXRouteOutput
+    uint8_t level;  // Return level
+} FXRoute;
+
+// A small routing graph over FX_GRAPH_SLOTS effect slots. setRoutes()
+// validates the routes on core0 and compiles them into a flat schedule:
+// one step per slot, in slot order, with the source and node buffers and
+// the gains already resolved. The audio core just walks the steps once per
+// block; it never looks at the graph. Schedules are double-buffered and
+// switched over with postCall(), between two blocks.
+class FXGraph {
+public:
+    FXGraph(FXSlot* slot1, FXSlot* slot2, FXSlot* slot3) : slots{slot1, slot2, slot3} {
+    }
+
+    // The rack's original wiring: 1 -> 2 on the left, 3 on the right
+    static void getDefaultRoutes(FXRoute routes[FX_GRAPH_SLOTS]) {
+        routes[0] = {FX_SOURCE_LEFT, 100, 100, FX_OUTPUT_NONE, 100};
+        routes[1] = {FX_SOURCE_SLOT1, 100, 100, FX_OUTPUT_LEFT, 100};
+        routes[2] = {FX_SOURCE_RIGHT, 100, 100, FX_OUTPUT_RIGHT, 100};
+    }
+
+    // Names used by the serial commands
+    static const char* getSourceName(uint8_t source) {
+        static const char* names[FX_SOURCE_COUNT] = {"left", "right", "mid", "side", "stereo", "fx1", "fx2"};
+        return source < FX_SOURCE_COUNT ? names[source] : "";
+    }
+
+    static const char* getOutputName(uint8_t output) {
+        static const char* names[FX_OUTPUT_COUNT] = {"none", "left", "right", "stereo", "side"};
+        return output < FX_OUTPUT_COUNT ? names[output] : "";
+    }
+
+    // False (with the reason printed) if a route is out of range or feeds
+    // from itself or a later slot
+    static bool validate(const FXRoute routes[FX_GRAPH_SLOTS]) {
+        for (uint8_t i = 0; i < FX_GRAPH_SLOTS; i++) {
+            const FXRoute& route = routes[i];
+            if (route.source >= FX_SOURCE_COUNT || route.output >= FX_OUTPUT_COUNT) {
+                printf("FX %d: unknown source or output\n", i + 1);
+                return false;
+            }
+            if (route.send > 100 || route.wet > 100 || route.level > 100) {
+                printf("FX %d: levels are 0-100\n", i + 1);
+                return false;
+            }
+            if (route.source >= FX_SOURCE_SLOT1 && route.source - FX_SOURCE_SLOT1 >= i) {
+                printf("FX %d can only take an earlier FX as its source\n", i + 1);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Compile and install `routes` (core0). Immediate if audio isn't
+    // running, otherwise from the next block. False if they don't validate
+    // or the previous routing hasn't been picked up yet (it will be within
+    // a block, so the caller can just try again; this never waits).
+    bool setRoutes(const FXRoute routes[FX_GRAPH_SLOTS], AudioManager* audioManager) {
+        if (!validate(routes)) {
+            return false;
+        }
+
+        if (!audioManager->isRunning()) {
+            switchPending = false;
+            compile(routes, schedules[active]);
+            return true;
+        }
+
+        if (switchPending) {
+            printf("Routing is still switching, try again\n");
+            return false;
+        }
+
+        uint8_t spare = 1 - active;
+        compile(routes, schedules[spare]);
+        switchPending = true;
+        if (!audioManager->postCall(switchSchedule, this, spare)) {
+            printf("Audio event queue full, try again\n");
+            switchPending = false;
+            return false;
+        }
+        return true;
+    }
+
+    // Run the schedule over one block (audio core)
+    __attribute__((hot)) void process(const float* inLeft, const float* inRight, float* outLeft, float* outRight, size_t frames) {
+        const Schedule& schedule = schedules[active];
+        memcpy(left, inLeft, frames * sizeof(float));
+        memcpy(right, inRight, frames * sizeof(float));
+
+        if (schedule.needsMidSide) {
+            for (size_t n = 0; n < frames; n++) {
+                mid[n] = 0.5f * (left[n] + right[n]);
+                side[n] = 0.5f * (left[n] - right[n]);
+            }
+        }
+
+        memset(outLeft, 0, frames * sizeof(float));
+        memset(outRight, 0, frames * sizeof(float));
+
+        float dryLeft[AUDIO_BLOCK_SIZE];
+        float dryRight[AUDIO_BLOCK_SIZE];
+        for (uint8_t s = 0; s < FX_GRAPH_SLOTS; s++) {
+            const Step& step = schedule.steps[s];
+            float* nodeLeft = nodes[s][0];
+            float* nodeRight = nodes[s][1];
+
+            // Send
+            if (step.send == 1.0f) {
+                memcpy(nodeLeft, step.sourceLeft, frames * sizeof(float));
+                memcpy(nodeRight, step.sourceRight, frames * sizeof(float));
+            } else {
+                for (size_t n = 0; n < frames; n++) {
+                    nodeLeft[n] = step.sourceLeft[n] * step.send;
+                    nodeRight[n] = step.sourceRight[n] * step.send;
+                }
+            }
+
+            // Every slot runs, routed or not, so its tails and any crossfade
+            // keep moving and nothing stale plays when it's routed back in
+            if (step.wet == 1.0f) {
+                step.slot->processBlock(nodeLeft, nodeRight, frames);
+            } else {
+                memcpy(dryLeft, nodeLeft, frames * sizeof(float));
+                memcpy(dryRight, nodeRight, frames * sizeof(float));
+                step.slot->processBlock(nodeLeft, nodeRight, frames);
+                const float dry = 1.0f - step.wet;
+                for (size_t n = 0; n < frames; n++) {
+                    nodeLeft[n] = nodeLeft[n] * step.wet + dryLeft[n] * dry;
+                    nodeRight[n] = nodeRight[n] * step.wet + dryRight[n] * dry;
+                }
+            }
+
+            // Return
+            if (step.leftGain != 0.0f) {
+                for (size_t n = 0; n < frames; n++) {
+                    outLeft[n] += nodeLeft[n] * step.leftGain;
+                }
+            }
+            if (step.rightGain != 0.0f) {
+                for (size_t n = 0; n < frames; n++) {
+                    outRight[n] += nodeRight[n] * step.rightGain;
+                }
+            }
+        }
+    }
+
+private:
+    typedef struct {
+        FXSlot* slot;
+        const float* sourceLeft;
+        const float* sourceRight;
+        float send;
+        float wet;
+        float leftGain;
+        float rightGain;
+    } Step;
+
+    typedef struct {
+        Step steps[FX_GRAPH_SLOTS];
+        bool needsMidSide;
+    } Schedule;
+
+    FXSlot* slots[FX_GRAPH_SLOTS];
+    Schedule schedules[2] = {};
+    volatile uint8_t active = 0;
+    volatile bool switchPending = false;
+
+    // Per-block buffers the schedule points into
+    float left[AUDIO_BLOCK_SIZE];
+    float right[AUDIO_BLOCK_SIZE];
+    float mid[AUDIO_BLOCK_SIZE];
+    float side[AUDIO_BLOCK_SIZE];
+    float nodes[FX_GRAPH_SLOTS][2][AUDIO_BLOCK_SIZE];
+
+    void compile(const FXRoute routes[FX_GRAPH_SLOTS], Schedule& schedule) {
+        schedule.needsMidSide = false;
+        for (uint8_t i = 0; i < FX_GRAPH_SLOTS; i++) {
+            const FXRoute& route = routes[i];
+            Step& step = schedule.steps[i];
+            step.slot = slots[i];
+
+            switch (route.source) {
+                case FX_SOURCE_LEFT: step.sourceLeft = step.sourceRight = left; break;
+                case FX_SOURCE_RIGHT: step.sourceLeft = step.sourceRight = right; break;
+                case FX_SOURCE_MID: step.sourceLeft = step.sourceRight = mid; break;
+                case FX_SOURCE_SIDE: step.sourceLeft = step.sourceRight = side; break;
+                case FX_SOURCE_STEREO:
+                    step.sourceLeft = left;
+                    step.sourceRight = right;
+                    break;
+                default: {
+                    uint8_t from = route.source - FX_SOURCE_SLOT1;
+                    step.sourceLeft = nodes[from][0];
+                    step.sourceRight = nodes[from][1];
+                    break;
+                }
+            }
+            if (route.source == FX_SOURCE_MID || route.source == FX_SOURCE_SIDE) {
+                schedule.needsMidSide = true;
+            }
+
+            step.send = route.send / 100.0f;
+            step.wet = route.wet / 100.0f;
+
+            float level = route.level / 100.0f;
+            step.leftGain = 0.0f;
+            step.rightGain = 0.0f;
+            switch (route.output) {
+                case FX_OUTPUT_LEFT: step.leftGain = level; break;
+                case FX_OUTPUT_RIGHT: step.rightGain = level; break;
+                case FX_OUTPUT_STEREO: step.leftGain = step.rightGain = level; break;
+                case FX_OUTPUT_SIDE:
+                    step.leftGain = level;
+                    step.rightGain = -level;
+                    break;
+            }
+        }
+    }
+
+    // Runs on the audio core between two blocks
+    static void switchSchedule(void* context, int32_t index) {
+        FXGraph* graph = (FXGraph*)context;
+        graph->active = index;
+        graph->switchPending = false;
+    }
+};
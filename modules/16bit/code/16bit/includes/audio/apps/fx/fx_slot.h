@@ -0,0 +1,168 @@
+#pragma once
+
+#include "audio/apps/interfaces/audio_fx.h"
+#include "audio/tools/fastmath.h"
+
+// Length of the equal-power crossfade when an effect is swapped live
+#ifndef FX_SLOT_FADE_MS
+#define FX_SLOT_FADE_MS 20
+#endif
+
+// An effect position in an app whose effect can be replaced while audio runs.
+// The new effect is built and initialised on core0, handed to the audio core
+// with postCall(), and crossfaded in; the old one comes back to core0 to be
+// deleted (and its PSRAM freed) in collect(), so the audio core never
+// allocates or frees. A swap asked for while another is still fading waits
+// on core0 and collect() starts it, so set() never blocks the main loop.
+// processBlock(), setGate() and setBPM() go to both effects during a fade;
+// everything else (`slot->setParameter()`) to the new one.
+class FXSlot {
+public:
+    FXSlot(AudioFX* fx) : active(fx) {
+    }
+
+    // Install `fx`, which must already be initialised (core0). Crossfades
+    // if audio is running, otherwise swaps straight away. If the previous
+    // swap is still fading, `fx` is queued (replacing any effect already
+    // queued) and collect() starts it once that one is done.
+    void set(AudioFX* fx, AudioManager* audioManager) {
+        if (!audioManager->isRunning()) {
+            // Nothing is rendering: any swap in flight was dropped with the
+            // event queue, so tidy it up here
+            delete queued;
+            delete pending;
+            delete outgoing;
+            delete retired;
+            queued = pending = outgoing = retired = nullptr;
+            fadeRemaining = 0;
+            swapInFlight = false;
+
+            delete active;
+            active = fx;
+            return;
+        }
+
+        this->audioManager = audioManager;
+        delete queued;
+        queued = fx;
+        startQueued();
+    }
+
+    // Delete the effect a finished fade handed back, and start a queued
+    // swap (core0, e.g. in update())
+    void collect() {
+        if (retired != nullptr) {
+            __dmb();
+            delete retired;
+            retired = nullptr;
+            swapInFlight = false;
+        }
+        startQueued();
+    }
+
+    // In place, as AudioFX::processBlock()
+    __attribute__((hot)) void processBlock(float* left, float* right, size_t frames) {
+        if (fadeRemaining == 0) {
+            active->processBlock(left, right, frames);
+            return;
+        }
+
+        float oldLeft[AUDIO_BLOCK_SIZE];
+        float oldRight[AUDIO_BLOCK_SIZE];
+        memcpy(oldLeft, left, frames * sizeof(float));
+        memcpy(oldRight, right, frames * sizeof(float));
+        outgoing->processBlock(oldLeft, oldRight, frames);
+        active->processBlock(left, right, frames);
+
+        size_t fading = MIN(frames, (size_t)fadeRemaining);
+        float in = fadeIn, out = fadeOut;
+        for (size_t n = 0; n < fading; n++) {
+            left[n] = left[n] * in + oldLeft[n] * out;
+            right[n] = right[n] * in + oldRight[n] * out;
+
+            // Rotate (out, in) a step along the quarter circle, so the
+            // summed power stays constant without a sin/cos per sample
+            float nextOut = out * stepCos - in * stepSin;
+            in = in * stepCos + out * stepSin;
+            out = nextOut;
+        }
+        fadeIn = in;
+        fadeOut = out;
+
+        fadeRemaining -= fading;
+        if (fadeRemaining == 0) {
+            // Hand it back once it has stopped being used
+            __dmb();
+            retired = outgoing;
+            outgoing = nullptr;
+        }
+    }
+
+    void setGate(bool gate) {
+        active->setGate(gate);
+        if (outgoing != nullptr) {
+            outgoing->setGate(gate);
+        }
+    }
+
+    void setBPM(uint16_t bpm) {
+        active->setBPM(bpm);
+        if (outgoing != nullptr) {
+            outgoing->setBPM(bpm);
+        }
+    }
+
+    // The current effect (the incoming one during a fade)
+    AudioFX* operator->() {
+        return active;
+    }
+
+private:
+    AudioFX* active;
+    AudioFX* outgoing = nullptr;       // Audio core, while fading out
+    AudioFX* queued = nullptr;         // core0, until the previous swap is done
+    AudioFX* pending = nullptr;        // core0 -> audio core, via postCall()
+    AudioFX* volatile retired = nullptr; // Audio core -> core0, see collect()
+    bool swapInFlight = false;         // core0 only
+    uint32_t fadeLength = 1;
+    uint32_t fadeRemaining = 0;
+    float fadeIn = 0.0f;
+    float fadeOut = 1.0f;
+    float stepCos = 1.0f;
+    float stepSin = 0.0f;
+    AudioManager* audioManager = nullptr;
+
+    // Hand the queued effect to the audio core, unless a swap is still in
+    // flight (core0)
+    void startQueued() {
+        if (queued == nullptr || swapInFlight || !audioManager->isRunning()) {
+            return;
+        }
+
+        fadeLength = MAX(1u, audioManager->getDac()->getSampleRate() * FX_SLOT_FADE_MS / 1000);
+        pending = queued;
+        swapInFlight = true;
+        if (!audioManager->postCall(beginFade, this)) {
+            // Event queue full: try again from the next collect()
+            pending = nullptr;
+            swapInFlight = false;
+            return;
+        }
+        queued = nullptr;
+    }
+
+    // Runs on the audio core between two blocks
+    static void beginFade(void* context, int32_t arg) {
+        FXSlot* slot = (FXSlot*)context;
+        slot->outgoing = slot->active;
+        slot->active = slot->pending;
+        slot->pending = nullptr;
+
+        float step = (float)M_PI * 0.5f / slot->fadeLength;
+        slot->stepCos = fastCos(step);
+        slot->stepSin = fastSin(step);
+        slot->fadeIn = 0.0f;
+        slot->fadeOut = 1.0f;
+        slot->fadeRemaining = slot->fadeLength;
+    }
+};
@@ -2,10 +2,13 @@
 
 #include "audio/apps/interfaces/audio_fx.h"
 #include "audio/mod/Delay.h"
+#include "audio/tools/fastmath.h"
 
 class MetalVerbFX : public AudioFX {
 private:
-    Delay delay{1000};
+    // Shakeness tops out at 1/8 beat at 120 BPM (62.5ms), short enough for
+    // the line to sit in on-chip SRAM, where float costs no extra traffic
+    Delay delay{65};
     float parameterValues[4];
 public:
     MetalVerbFX() {
@@ -33,12 +36,21 @@ public:
 
     virtual void init(AudioManager* audioManager) override {
         delay.init(audioManager);
+        // The short, high-feedback repeats go round the loop many times, so
+        // read them with the flatter cubic rather than dulling each pass
+        delay.setInterpolation(DELAY_INTERP_HERMITE);
         delay.setBPM(120);
     }
 
     virtual float process(float input) override {
         return delay.process(input);
     }
+
+    virtual void processBlock(float* left, float* right, size_t frames) override {
+        foldToMono(left, right, frames);
+        delay.processBlock(left, frames);
+        spreadMono(left, right, frames);
+    }
     
     virtual void setBPM(uint16_t bpm) override {
         // for metalverb, we don't need to change the sound based on the bpm
@@ -67,7 +79,7 @@ public:
             }
             case 3: {
                 float oneMinusValueNormalized = 1.0 - value;
-                float cutoff = 100.0f * powf(20000.0f / 100.0f, oneMinusValueNormalized * oneMinusValueNormalized);
+                float cutoff = expRange(100.0f, 20000.0f, oneMinusValueNormalized * oneMinusValueNormalized);
                 delay.setLowpassCutoff(cutoff);
                 break;
             }
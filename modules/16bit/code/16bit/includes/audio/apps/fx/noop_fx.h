@@ -28,6 +28,10 @@ public:
         return input;
     }
 
+    virtual void processBlock(float* left, float* right, size_t frames) override {
+        // Stereo passes straight through
+    }
+
     virtual void setBPM(uint16_t bpm) override {
         // noop
     }
@@ -2,12 +2,12 @@
 
 #include "audio/apps/interfaces/audio_fx.h"
 #include "audio/mod/Delay.h"
-#include "audio/mod/biquad.h"
+#include "audio/mod/Biquad.h"
 
 class RumbleFX : public AudioFX {
 
 private:
-    Delay delay{2000}; // Longer buffer for rumble
+    Delay delay{2000, DELAY_STORAGE_INT16}; // Longer buffer for rumble
     Biquad lowpass{Biquad::FilterType::LOWPASS};
     Biquad preFilter{Biquad::FilterType::LOWPASS}; // Remove click before delay
     float parameterValues[4];
@@ -121,6 +121,61 @@ public:
         float rumbleVol = parameterValues[2];
         return dry + wet * rumbleVol / 2.0f;
     }
+
+    // The same stages as process(), each over the whole block. The gate is
+    // taken as constant across the block: split it where the gate changes.
+    virtual void processBlock(float* left, float* right, size_t frames) override {
+        foldToMono(left, right, frames);
+
+        // 1-2. The wet path is built up in right[], the dry signal stays in left[]
+        memcpy(right, left, frames * sizeof(float));
+        preFilter.processBlock(right, frames);
+        delay.processBlock(right, frames);
+
+        // 3. Drive and downsampling
+        if (drive > 0.0f) {
+            const float gain = 1.0f + drive * 20.0f;
+            for (size_t n = 0; n < frames; n++) {
+                right[n] = std::clamp(right[n] * gain, -1.0f, 1.0f);
+            }
+
+            if (drive > 0.1f) {
+                const float reduction = 1.0f + (drive - 0.1f) * 30.0f;
+                float phase = crushPhase;
+                float held = crushLastSample;
+                for (size_t n = 0; n < frames; n++) {
+                    phase += 1.0f;
+                    if (phase >= reduction) {
+                        phase -= reduction;
+                        held = right[n];
+                    } else {
+                        right[n] = held;
+                    }
+                }
+                crushPhase = phase;
+                crushLastSample = held;
+            }
+        }
+
+        // 4. Lowpass
+        lowpass.processBlock(right, frames);
+
+        // 5-6. Sidechain ducking and the mix
+        if (gateState && !lastGateState) {
+            currentGain = 0.0f;
+        }
+        lastGateState = gateState;
+
+        const float rumbleVol = parameterValues[2];
+        float gain = currentGain;
+        for (size_t n = 0; n < frames; n++) {
+            gain += (1.0f - gain) * release;
+            left[n] += right[n] * gain * rumbleVol / 2.0f;
+        }
+        currentGain = gain;
+
+        spreadMono(left, right, frames);
+    }
     
     virtual void setBPM(uint16_t bpm) override {
         delay.setBPM(bpm);
@@ -3,17 +3,20 @@
 #include <algorithm>
 #include "io.h"
 #include "midi.h"
-#include "fs/fs.h"
-#include "psram.h"
+#include "fs/FS.h"
 #include "audio/manager.h"
-#include "audio/mod/biquad.h"
+#include "audio/mod/Biquad.h"
+#include "audio/tools/fastmath.h"
 #include "audio/tools/sample_player.h"
 #include "api/web_serial.h"
+#include "fs/config.h"
 #include "audio/apps/interfaces/audio_app.h"
 
 #include "audio/apps/fx/delay_fx.h"
 #include "audio/apps/fx/noop_fx.h"
 #include "audio/apps/fx/metalverb_fx.h"
+#include "audio/apps/fx/fx_slot.h"
+#include "audio/apps/fx/fx_graph.h"
 
 #define TOTAL_SAMPLE_PLAYERS 12
 
@@ -21,6 +24,10 @@
 #define CONFIG_FX2_INDEX 1
 #define CONFIG_FX3_INDEX 2
 #define CONFIG_SPLIT_AUDIO_INDEX 3
+// Then one FXRoute per slot, a byte per field
+#define CONFIG_ROUTE_INDEX 4
+#define CONFIG_ROUTE_FIELDS 5
+#define CONFIG_LENGTH (CONFIG_ROUTE_INDEX + FX_GRAPH_SLOTS * CONFIG_ROUTE_FIELDS)
 
 #define CONFIG_FX_NOOP 0
 #define CONFIG_FX_DELAY 1
@@ -31,19 +38,19 @@ private:
     static FXRackApp* instance;
     FS *fs = FS::getInstance();
     IO *io = IO::getInstance();
-    PSRAM *psram = PSRAM::getInstance();
     AudioManager *audioManager = AudioManager::getInstance();
     MIDI *midi = MIDI::getInstance();
     WebSerial* webSerial = WebSerial::getInstance();
     Biquad lowpassFilterA{Biquad::FilterType::LOWPASS};
     Biquad lowpassFilterB{Biquad::FilterType::LOWPASS};
-    AudioFX* fx1 = new DelayFX;
-    AudioFX* fx2 = new MetalVerbFX;
-    AudioFX* fx3 = new NoopFX;
+    FXSlot fx1{new DelayFX};
+    FXSlot fx2{new MetalVerbFX};
+    FXSlot fx3{new NoopFX};
+    FXGraph graph{&fx1, &fx2, &fx3};
 
     uint16_t currentBPM = 120;
 
-    Config config{4, "/fxrack_config.dat"};
+    Config config{CONFIG_LENGTH, "/fxrack_config.dat"};
 
 public:
     FXRackApp() {}
@@ -51,10 +58,11 @@ public:
     static AudioApp* getInstance();
 
     void init() override;
-    void audioCallback(AudioInput *input, AudioOutput *output) override;
+    void processBlock(const AudioInput* input, AudioOutput* output, size_t frames) override;
     void noteOnCallback(uint8_t channel, uint8_t note, uint8_t velocity) override;
     void noteOffCallback(uint8_t channel, uint8_t note, uint8_t velocity) override;
     void ccChangeCallback(uint8_t channel, uint8_t cc, uint8_t value) override;
+    void pitchBendCallback(uint8_t channel, int16_t bend) override;
     void cv1UpdateCallback(uint16_t cv1) override;
     void cv2UpdateCallback(uint16_t cv2) override;
     void buttonPressedCallback(bool pressed) override;
@@ -62,5 +70,7 @@ public:
     void update() override;
     bool onCommandCallback(const char* cmd) override;
 
-    void setFX(int8_t index, int8_t value);
+    bool setFX(int8_t index, int8_t value);
+    void loadRoutes(FXRoute routes[FX_GRAPH_SLOTS]);
+    void saveRoutes(const FXRoute routes[FX_GRAPH_SLOTS]);
 };
@@ -8,7 +8,10 @@ public:
     
     // Core audio processing methods
     virtual void init() = 0;
-    virtual void audioCallback(AudioInput *input, AudioOutput *output) = 0;
+
+    // Render a block of `frames` (at most AUDIO_BLOCK_SIZE) stereo frames.
+    // input[n] is the audio-in frame that lines up with output[n].
+    virtual void processBlock(const AudioInput* input, AudioOutput* output, size_t frames) = 0;
 
     // Update method for handling UI and other non-audio updates
     virtual void update() = 0;
@@ -17,6 +20,8 @@ public:
     virtual void noteOnCallback(uint8_t channel, uint8_t note, uint8_t velocity) = 0;
     virtual void noteOffCallback(uint8_t channel, uint8_t note, uint8_t velocity) = 0;
     virtual void ccChangeCallback(uint8_t channel, uint8_t cc, uint8_t value) = 0;
+    // bend is -8192..8191, 0 is centred
+    virtual void pitchBendCallback(uint8_t channel, int16_t bend) = 0;
     virtual void bpmChangeCallback(int bpm) = 0;
     
     // Knobs and buttons
@@ -26,4 +31,4 @@ public:
     
     // System callback methods
     virtual bool onCommandCallback(const char* cmd) = 0;
-}; 
\ No newline at end of file
+}; 
@@ -1,5 +1,6 @@
 #pragma once    
 
+#include <string.h>
 #include "audio/manager.h"
 
 class AudioFX {
@@ -12,8 +13,35 @@ public:
     
     virtual void init(AudioManager* audioManager) = 0;
     virtual float process(float input) = 0;
+
+    // Process a stereo block in place. An effect that doesn't override this
+    // is mono: it runs process() on the middle of the two channels and
+    // returns the result to both (bit-exact for a mono signal fed as L = R).
+    // Stereo effects override it to treat the channels separately.
+    virtual void processBlock(float* left, float* right, size_t frames) {
+        for (size_t n = 0; n < frames; n++) {
+            float out = process(0.5f * (left[n] + right[n]));
+            left[n] = out;
+            right[n] = out;
+        }
+    }
+
     virtual void setGate(bool gate) = 0;
     virtual void setBPM(uint16_t bpm) = 0;
     virtual void setParameter(uint8_t parameter, float value) = 0;
     virtual float getParameter(uint8_t parameter) = 0;
+
+protected:
+    // For mono effects with their own processBlock(): the middle of the two
+    // channels into left[], to be processed there...
+    static inline void foldToMono(float* left, const float* right, size_t frames) {
+        for (size_t n = 0; n < frames; n++) {
+            left[n] = 0.5f * (left[n] + right[n]);
+        }
+    }
+
+    // ...and copied back out to right[] afterwards
+    static inline void spreadMono(const float* left, float* right, size_t frames) {
+        memcpy(right, left, frames * sizeof(float));
+    }
 };
\ No newline at end of file
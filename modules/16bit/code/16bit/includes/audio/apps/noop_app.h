@@ -8,11 +8,12 @@ private:
     AudioManager *audioManager = AudioManager::getInstance();
 public:
     void init() override;
-    void audioCallback(AudioInput *input, AudioOutput *output) override;
+    void processBlock(const AudioInput* input, AudioOutput* output, size_t frames) override;
     void update() override;
     void noteOnCallback(uint8_t channel, uint8_t note, uint8_t velocity) override;
     void noteOffCallback(uint8_t channel, uint8_t note, uint8_t velocity) override;
     void ccChangeCallback(uint8_t channel, uint8_t cc, uint8_t value) override;
+    void pitchBendCallback(uint8_t channel, int16_t bend) override;
     void bpmChangeCallback(int bpm) override;
     void cv1UpdateCallback(uint16_t cv1) override;
     void cv2UpdateCallback(uint16_t cv2) override;
@@ -5,22 +5,44 @@
 #include "api/web_serial.h"
 #include "audio/manager.h"
 #include "audio/apps/interfaces/audio_app.h"
-#include "audio/gen/Sine.h"
-#include "audio/gen/Saw.h"
-#include "audio/gen/Tri.h"
-#include "audio/gen/Square.h"
-#include "audio/env/AttackHoldRelease.h"
-#include "audio/env/Envelope.h"
+#include "audio/gen/Wavetable.h"
+#include "audio/tools/VoiceEngine.h"
 #include "audio/tools/Voice.h"
+#include "audio/tools/VoiceAllocator.h"
+#include "audio/tools/fastmath.h"
 #include "fs/config.h"
 #include "audio/apps/fx/filter_fx.h"
 
-#define TOTAL_VOICES 9
+#define TOTAL_VOICES 18
+// Mix level of each voice, kept from when there were 9 voices so a single
+// note is as loud as it was
+#define VOICE_MIX_GAIN 0.25f
 
 #define CONFIG_WAVEFORM_INDEX 0
 #define CONFIG_WAVEFORM_SAW 0
 #define CONFIG_WAVEFORM_SQUARE 1
 #define CONFIG_WAVEFORM_TRI 2
+#define CONFIG_WAVEFORM_BL_SAW 3
+#define CONFIG_WAVEFORM_BL_SQUARE 4
+#define CONFIG_WAVEFORM_BL_TRI 5
+#define CONFIG_WAVEFORM_WAVETABLE 6
+#define CONFIG_WAVETABLE_SLOT_INDEX 1
+#define CONFIG_VOICE_STEAL_INDEX 2
+
+// Pitch bend wheel range in semitones (either way)
+#define PITCH_BEND_RANGE 2.0f
+
+// MIDI CC that morphs through the frames of the wavetable (mod wheel)
+#define WAVETABLE_MORPH_CC 1
+
+// MIDI CCs of the per-voice filter
+#define VOICE_FILTER_CUTOFF_CC 24
+#define VOICE_FILTER_RESONANCE_CC 25
+#define VOICE_FILTER_ENV_AMOUNT_CC 26
+#define VOICE_FILTER_ENV_RELEASE_CC 27
+#define VOICE_FILTER_KEY_TRACK_CC 28
+// Filter envelope depth at full CC, in octaves
+#define VOICE_FILTER_MAX_ENV_OCTAVES 6.0f
 
 class PolySynthApp : public AudioApp {
 private:
@@ -28,33 +50,28 @@ private:
     IO *io = IO::getInstance();
     WebSerial *webSerial = WebSerial::getInstance();
     AudioManager *audioManager = AudioManager::getInstance();
-    uint8_t generatorIndex = 0;
-    Saw sawGenerators[TOTAL_VOICES];
-    Tri triGenerators[TOTAL_VOICES];
-    Square squareGenerators[TOTAL_VOICES];
+    // Oscillators and envelopes of every voice, rendered a block at a time
+    VoiceEngine voiceEngine;
+    Wavetable wavetableGenerators[TOTAL_VOICES];
     AudioFX* fx1 = new FilterFX();
-    Config config{1, "/polysynth_config.dat"};
+    Config config{3, "/polysynth_config.dat"};
+    int8_t waveform = CONFIG_WAVEFORM_SAW;
 
     Voice* voices[TOTAL_VOICES];
+    VoiceAllocator voiceAllocator;
 
     int8_t totalNotesOn = 0;
 
-    Voice* findFreeVoice() {
-        for (int i = 0; i < TOTAL_VOICES; i++) {
-            if (!voices[i]->getAmpEnvelope()->isActive()) {
-                return voices[i];
-            }
-        }
-        return nullptr;
-    }
+    VoiceStealMode getVoiceStealMode();
 
 public:
     void init() override;
-    void audioCallback(AudioInput *input, AudioOutput *output) override;
+    void processBlock(const AudioInput* input, AudioOutput* output, size_t frames) override;
     void update() override;
     void noteOnCallback(uint8_t channel, uint8_t note, uint8_t velocity) override;
     void noteOffCallback(uint8_t channel, uint8_t note, uint8_t velocity) override;
     void ccChangeCallback(uint8_t channel, uint8_t cc, uint8_t value) override;
+    void pitchBendCallback(uint8_t channel, int16_t bend) override;
     void bpmChangeCallback(int bpm) override;
     void cv1UpdateCallback(uint16_t cv1) override;
     void cv2UpdateCallback(uint16_t cv2) override;
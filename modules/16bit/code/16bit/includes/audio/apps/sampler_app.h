@@ -3,19 +3,21 @@
 #include <algorithm>
 #include "io.h"
 #include "midi.h"
-#include "fs/fs.h"
-#include "psram.h"
+#include "fs/FS.h"
 #include "audio/manager.h"
 #include "audio/samples/s01.h"
-#include "audio/mod/biquad.h"
+#include "audio/mod/BiquadCascade.h"
+#include "audio/tools/fastmath.h"
 #include "audio/tools/sample_player.h"
 #include "api/web_serial.h"
+#include "fs/config.h"
 #include "audio/apps/interfaces/audio_app.h"
 
 #include "audio/apps/fx/delay_fx.h"
 #include "audio/apps/fx/rumble_fx.h"
 #include "audio/apps/fx/noop_fx.h"
 #include "audio/apps/fx/metalverb_fx.h"
+#include "audio/apps/fx/fx_slot.h"
 
 #define TOTAL_SAMPLE_PLAYERS 12
 
@@ -34,15 +36,14 @@ class SamplerApp : public AudioApp {
         static SamplerApp* instance;
         FS *fs = FS::getInstance();
         IO *io = IO::getInstance();
-        PSRAM *psram = PSRAM::getInstance();
         AudioManager *audioManager = AudioManager::getInstance();
         MIDI *midi = MIDI::getInstance();
         WebSerial* webSerial = WebSerial::getInstance();
-        Biquad lowpassFilter{Biquad::FilterType::LOWPASS};
-        Biquad highpassFilter{Biquad::FilterType::HIGHPASS};
-        AudioFX* fx1 = new RumbleFX;
-        AudioFX* fx2 = new MetalVerbFX;
-        AudioFX* fx3 = new NoopFX;
+        // Group A tone: section 0 low-pass (CV1), section 1 high-pass (CV2)
+        BiquadCascade groupAFilter{2};
+        FXSlot fx1{new RumbleFX};
+        FXSlot fx2{new MetalVerbFX};
+        FXSlot fx3{new NoopFX};
 
         uint16_t currentBPM = 120;
 
@@ -61,6 +62,23 @@ class SamplerApp : public AudioApp {
             SamplePlayer(11)
         };
 
+        // Runs on the audio core (MIDI notes arrive there as queued events)
+        void trigger(uint8_t sampleId, float velocity) {
+            if (sampleId == 0) {
+                // Keep current playback method for sampleId 0
+                defaultSamplePlayhead = 0;
+                velocityOfDefaultSample = velocity;
+            } else if (sampleId < TOTAL_SAMPLE_PLAYERS) {
+                // Use SamplePlayer for sampleId 1 to 11
+                players[sampleId].play(velocity);
+            }
+        }
+
+        // For triggers from core0 (commands, button), posted via postCall()
+        static void triggerFromCore0(void* context, int32_t sampleId) {
+            ((SamplerApp*)context)->trigger(sampleId, 0.8f);
+        }
+
     public:
         SamplerApp() {
 
@@ -75,9 +93,8 @@ class SamplerApp : public AudioApp {
 
         void init() override {
             audioManager->setAdcEnabled(false);
-            psram->freeall();
-            lowpassFilter.init(audioManager);
-            highpassFilter.init(audioManager);
+            groupAFilter.setMode(1, BIQUAD_HIGHPASS);
+            groupAFilter.init(audioManager);
             fx1->init(audioManager);
             fx2->init(audioManager);
             fx3->init(audioManager);
@@ -97,63 +114,63 @@ class SamplerApp : public AudioApp {
             
         }
 
-        __attribute__((hot)) void audioCallback(AudioInput *input, AudioOutput *output) override {
-            audioManager->startAudioLock();
+        __attribute__((hot)) void processBlock(const AudioInput* input, AudioOutput* output, size_t frames) override {
+            float sumGroupA[AUDIO_BLOCK_SIZE] = {};
+            float sumGroupB[AUDIO_BLOCK_SIZE] = {};
+            bool kickGate[AUDIO_BLOCK_SIZE];
 
             // first 6 samples has FX support & others are just playing (no fx)
-            float sumGroupA = 0.0f;
-
-            if (defaultSamplePlayhead < defaultSampleLen) {
-                sumGroupA += (defaultSample[defaultSamplePlayhead++] / 32768.0f) * velocityOfDefaultSample;
+            for (size_t n = 0; n < frames; ++n) {
+                if (defaultSamplePlayhead < defaultSampleLen) {
+                    sumGroupA[n] = (defaultSample[defaultSamplePlayhead++] / 32768.0f) * velocityOfDefaultSample;
+                }
+                // Sidechain gate for FX1 (Rumble)
+                // Trigger sidechain when the kick (default sample) is playing
+                kickGate[n] = defaultSamplePlayhead < defaultSampleLen;
             }
 
             for (int i = 0; i < 6; ++i) {
-                sumGroupA += players[i].process() / 32768.0f;
+                players[i].mix(sumGroupA, frames);
             }
-            
-            // Sidechain gate for FX1 (Rumble)
-            // Trigger sidechain when the kick (default sample) is playing
-            fx1->setGate(defaultSamplePlayhead < defaultSampleLen);
 
-            float sumGroupB = 0.0f;
             for (int i = 6; i < TOTAL_SAMPLE_PLAYERS; ++i) {
-                sumGroupB += players[i].process() / 32768.0f;
+                players[i].mix(sumGroupB, frames);
             }
 
-            audioManager->endAudioLock();
-
-            sumGroupA = lowpassFilter.process(sumGroupA);
-            sumGroupA = highpassFilter.process(sumGroupA);
-
-            // Apply FX to group A
-            sumGroupA = fx1->process(sumGroupA);
-            sumGroupA = fx2->process(sumGroupA);
+            groupAFilter.processBlock(sumGroupA, frames);
+
+            // The groups are mono up to here and stereo through the FX
+            float groupARight[AUDIO_BLOCK_SIZE];
+            float groupBRight[AUDIO_BLOCK_SIZE];
+            memcpy(groupARight, sumGroupA, frames * sizeof(float));
+            memcpy(groupBRight, sumGroupB, frames * sizeof(float));
+
+            // Apply FX to group A. FX1 (Rumble) is split where the kick
+            // gate changes, so the sidechain still ducks on the right sample.
+            size_t start = 0;
+            for (size_t n = 1; n <= frames; ++n) {
+                if (n == frames || kickGate[n] != kickGate[start]) {
+                    fx1.setGate(kickGate[start]);
+                    fx1.processBlock(sumGroupA + start, groupARight + start, n - start);
+                    start = n;
+                }
+            }
+            fx2.processBlock(sumGroupA, groupARight, frames);
 
             // Apply FX to group B
-            sumGroupB = fx3->process(sumGroupB);
-
-            float sampleSum = sumGroupB + sumGroupA;
+            fx3.processBlock(sumGroupB, groupBRight, frames);
 
-            output->left = sampleSum;
-            output->right = sampleSum;
+            for (size_t n = 0; n < frames; ++n) {
+                output[n].left = sumGroupA[n] + sumGroupB[n];
+                output[n].right = groupARight[n] + groupBRight[n];
+            }
         }
 
         __attribute__((cold, noinline)) void noteOnCallback(uint8_t channel, uint8_t note, uint8_t velocity) override {
             uint8_t sampleToPlay = note % 12;
-            // Keep current playback method for sampleId 0
             float velocityNorm = velocity / 127.0f;
             float realVelocity = powf(velocityNorm, 2.0f);
-            if (sampleToPlay == 0) {
-                audioManager->startAudioLock();
-                defaultSamplePlayhead = 0;
-                velocityOfDefaultSample = realVelocity;
-                audioManager->endAudioLock();
-            } else if (sampleToPlay <= 11) {
-                // Use SamplePlayer for sampleId 1 to 11
-                audioManager->startAudioLock();
-                players[sampleToPlay].play(realVelocity);
-                audioManager->endAudioLock();
-            }
+            trigger(sampleToPlay, realVelocity);
         }
 
         __attribute__((cold, noinline)) void noteOffCallback(uint8_t channel, uint8_t note, uint8_t velocity) override {   
@@ -205,14 +222,14 @@ class SamplerApp : public AudioApp {
 
         __attribute__((cold, noinline)) void cv1UpdateCallback(uint16_t cv1) override {
             float cv1Norm = 1.0 - IO::normalizeCV(cv1);
-            float cutoff = 50.0f * powf(20000.0f / 50.0f, cv1Norm * cv1Norm);
-            lowpassFilter.setCutoff(cutoff);
+            float cutoff = expRange(50.0f, 20000.0f, cv1Norm * cv1Norm);
+            groupAFilter.setCutoff(0, cutoff);
         }
 
         __attribute__((cold, noinline)) void cv2UpdateCallback(uint16_t cv2) override {
             float cv2Norm = IO::normalizeCV(cv2);
-            float cutoff = 20.0f * powf(20000.0f / 20.0f, cv2Norm);
-            highpassFilter.setCutoff(cutoff);
+            float cutoff = expRange(20.0f, 20000.0f, cv2Norm);
+            groupAFilter.setCutoff(1, cutoff);
         }
 
         __attribute__((cold, noinline)) void buttonPressedCallback(bool pressed) override {
@@ -226,22 +243,21 @@ class SamplerApp : public AudioApp {
                 io->setLED(false);
                 
                 // Initialize streaming state
-                audioManager->startAudioLock();
-                defaultSamplePlayhead = 0;
-                velocityOfDefaultSample = 0.8f;
-                audioManager->endAudioLock();
+                audioManager->postCall(triggerFromCore0, this, 0);
             }
         }
 
+        __attribute__((cold, noinline)) void pitchBendCallback(uint8_t channel, int16_t bend) override {}
+
         __attribute__((cold, noinline)) void bpmChangeCallback(int bpm) override {
             currentBPM = bpm;
-            fx1->setBPM(bpm);
-            fx2->setBPM(bpm);
-            fx3->setBPM(bpm);
+            fx1.setBPM(bpm);
+            fx2.setBPM(bpm);
+            fx3.setBPM(bpm);
         }
 
-        void setFX(int8_t index, int8_t value) {
-            AudioFX** targetFx = nullptr;
+        bool setFX(int8_t index, int8_t value) {
+            FXSlot* targetFx = nullptr;
             switch (index) {
                 case CONFIG_FX1_INDEX:
                     targetFx = &fx1;
@@ -253,7 +269,7 @@ class SamplerApp : public AudioApp {
                     targetFx = &fx3;
                     break;
                 default:
-                    return;
+                    return false;
             }
 
             AudioFX* newFx = nullptr;
@@ -271,14 +287,16 @@ class SamplerApp : public AudioApp {
                     newFx = new RumbleFX;
                     break;
                 default:
-                    return;
+                    return false;
             }
 
+            // Prepared here on core0 (its filters design their own coefficients
+            // rather than share the audio core's BiquadCache); the slot
+            // crossfades to it if audio is running, after any swap still fading
             newFx->init(audioManager);
             newFx->setBPM(currentBPM);
-            AudioFX* fxToDelete = *targetFx;
-            *targetFx = newFx;
-            delete fxToDelete;
+            targetFx->set(newFx, audioManager);
+            return true;
         }
 
         bool onCommandCallback(const char* cmd) override {
@@ -296,14 +314,7 @@ class SamplerApp : public AudioApp {
                     return true;
                 }
 
-                audioManager->startAudioLock();
-                if (sampleId == 0) {
-                    defaultSamplePlayhead = 0;
-                    velocityOfDefaultSample = 0.8f;
-                } else {
-                    players[sampleId].play(0.8f);
-                }
-                audioManager->endAudioLock();
+                audioManager->postCall(triggerFromCore0, this, sampleId);
 
                 return true;
             }
@@ -339,13 +350,12 @@ class SamplerApp : public AudioApp {
                     return true;
                 }
 
-                // Stop the audio manager & save the config
-                // Once we start the audio manager, it will reload this app
-                // So it will load the fx from the config
-                audioManager->stop();
-                config.set(fxIndex, newFx);
-                config.save();
-                audioManager->start();
+                // Swapped live, with a crossfade; the samples stay loaded.
+                // Saved from update() once the choice has settled.
+                if (setFX(fxIndex, newFx)) {
+                    config.set(fxIndex, newFx);
+                    config.saveLater();
+                }
                 return true;
             }
 
@@ -390,7 +400,10 @@ class SamplerApp : public AudioApp {
                     return false;
                 }
 
-                bool accepted = webSerial->acceptBinary(originalSize, base64Size, [sampleId](uint8_t* data, int size) {
+                bool accepted = webSerial->acceptBinary(originalSize, base64Size, [this, sampleId](uint8_t* data, int size) {
+                    // Don't stream from the file while it's rewritten; the
+                    // new sample is loaded when the app next starts
+                    players[sampleId].closeStream();
                     if(SamplePlayer::saveSample(sampleId, data, size)) {
                         printf("Sample %02d saved\n", sampleId);
                     } else {
@@ -406,11 +419,29 @@ class SamplerApp : public AudioApp {
                 return true;
             }
 
+            // Blocks, over all players, where a streamed sample wasn't read from flash in time
+            if (strncmp(cmd, "stream-underruns", 16) == 0) {
+                uint32_t underruns = 0;
+                for (int i = 0; i < TOTAL_SAMPLE_PLAYERS; i++) {
+                    underruns += players[i].getUnderruns();
+                }
+                webSerial->sendValue((int)underruns);
+                return true;
+            }
+
             return false;
         }
 
+        // Reads the streamed samples ahead and deletes effects that
+        // finished fading out
         void update() override {
-
+            for (int i = 0; i < TOTAL_SAMPLE_PLAYERS; i++) {
+                players[i].stream();
+            }
+            fx1.collect();
+            fx2.collect();
+            fx3.collect();
+            config.saveIfIdle();
         }
 };
 
@@ -2,15 +2,30 @@
 
 #include <stdio.h>
 #include <math.h>
+#include <string.h>
 #include "pico/stdlib.h"
 #include "hardware/clocks.h"
 #include "hardware/pio.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/sync.h"
 #include "i2s.pio.h"
 
+// DMA_IRQ_0 is left for the rest of the firmware
+#define DAC_DMA_IRQ DMA_IRQ_1
+
+class DAC;
+DAC* dac_dma_instance = nullptr;
+
 // This is I2S DAC implementation for the PT8211
 // Here we use Rasberry Pi's PIO to implement the I2S
-// This DAC directly write samples to the FIFO queue with blocking
-// If you need to use a buffer, use a DMA subsystem seperately
+// It has two ways to feed the PIO:
+//  - writeStereo()/writeMono() write samples to the FIFO queue with blocking
+//  - the DMA mode (initDma/startDma) plays two buffers back to back (ping-pong)
+//    while the CPU renders the next block into whichever buffer is free.
+//    Each channel's read address wraps back to the start of its buffer in
+//    hardware (ring mode), so playback keeps going on valid blocks even when
+//    the rendering core can't take interrupts.
 class DAC {
 private:
     PIO pio;
@@ -19,6 +34,38 @@ private:
     uint32_t sample_rate;
     uint bck_pin;
 
+    // DMA ping-pong state
+    // Each channel plays one buffer and chains to the other channel when done
+    int dmaChannels[2] = {-1, -1};
+    uint32_t* dmaBuffers[2] = {nullptr, nullptr};
+    uint32_t dmaFrames = 0;
+    uint8_t nextBuffer = 0;
+    bool dmaRunning = false;
+    // Set by the IRQ when DMA is done with a buffer, cleared by submitBuffer()
+    volatile bool bufferFree[2] = {false, false};
+    volatile uint32_t underruns = 0;
+
+    static void __isr dmaIrqHandler() {
+        DAC* dac = dac_dma_instance;
+        for (int i = 0; i < 2; i++) {
+            uint channel = dac->dmaChannels[i];
+            if (!dma_channel_get_irq1_status(channel)) {
+                continue;
+            }
+
+            dma_channel_acknowledge_irq1(channel);
+            // No re-arming: the read ring has already wrapped the channel
+            // back to the start of its buffer.
+
+            // Nobody refilled this buffer since it was last freed,
+            // so the DAC just replayed a stale block.
+            if (dac->bufferFree[i]) {
+                dac->underruns = dac->underruns + 1;
+            }
+            dac->bufferFree[i] = true;
+        }
+    }
+
     uint32_t getDesiredClockKhz(uint32_t sample_rate) {
         if (sample_rate % 8000 == 0) {
             return 144000;
@@ -89,9 +136,105 @@ public:
     // Write left & right values to the DAC
     // This is a stereo DAC, so we need to send two 16-bit samples
     void writeMono(int16_t left, int16_t right) {
-        // Combine the two 16-bit samples into a single 32-bit word
-        int32_t combined_sample = ((int32_t)right << 16) | (left & 0xFFFF);
-        writeStereo(combined_sample);
+        writeStereo(packStereo(left, right));
+    }
+
+    // Combine the two 16-bit samples into the 32-bit word writeStereo() expects
+    static inline uint32_t packStereo(int16_t left, int16_t right) {
+        return ((uint32_t)(uint16_t)right << 16) | (uint16_t)left;
+    }
+
+    // Setup the ping-pong DMA channels. Call once from core0 after init().
+    // Both buffers must hold `frames` words (a power of two), be aligned to
+    // their size for the read ring, and stay alive while DMA runs.
+    void initDma(uint32_t* bufferA, uint32_t* bufferB, uint32_t frames) {
+        dmaBuffers[0] = bufferA;
+        dmaBuffers[1] = bufferB;
+        dmaFrames = frames;
+        dmaChannels[0] = dma_claim_unused_channel(true);
+        dmaChannels[1] = dma_claim_unused_channel(true);
+        dac_dma_instance = this;
+    }
+
+    // Start playing the buffers. Call this from the core that renders audio,
+    // because the completion IRQ is enabled on the calling core.
+    void startDma() {
+        for (int i = 0; i < 2; i++) {
+            memset(dmaBuffers[i], 0, dmaFrames * sizeof(uint32_t));
+
+            dma_channel_config c = dma_channel_get_default_config(dmaChannels[i]);
+            channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+            channel_config_set_read_increment(&c, true);
+            channel_config_set_ring(&c, false, __builtin_ctz(dmaFrames * sizeof(uint32_t)));
+            channel_config_set_write_increment(&c, false);
+            channel_config_set_dreq(&c, pio_get_dreq(pio, sm, true));
+            channel_config_set_chain_to(&c, dmaChannels[1 - i]);
+            dma_channel_configure(dmaChannels[i], &c, &pio->txf[sm], dmaBuffers[i], dmaFrames, false);
+            dma_channel_set_irq1_enabled(dmaChannels[i], true);
+        }
+
+        underruns = 0;
+        nextBuffer = 1;
+        bufferFree[0] = false;
+        bufferFree[1] = true;
+
+        irq_set_exclusive_handler(DAC_DMA_IRQ, dmaIrqHandler);
+        irq_set_enabled(DAC_DMA_IRQ, true);
+
+        // Buffer A plays silence while the first block is rendered into buffer B
+        dma_channel_start(dmaChannels[0]);
+        dmaRunning = true;
+    }
+
+    void stopDma() {
+        if (!dmaRunning) {
+            return;
+        }
+
+        irq_set_enabled(DAC_DMA_IRQ, false);
+        for (int i = 0; i < 2; i++) {
+            // Break the chain first, so aborting one channel can't start the other
+            hw_clear_bits(&dma_channel_hw_addr(dmaChannels[i])->al1_ctrl, DMA_CH0_CTRL_TRIG_EN_BITS);
+        }
+
+        for (int i = 0; i < 2; i++) {
+            dma_channel_set_irq1_enabled(dmaChannels[i], false);
+            dma_channel_abort(dmaChannels[i]);
+            dma_channel_acknowledge_irq1(dmaChannels[i]);
+        }
+        dmaRunning = false;
+    }
+
+    // Wait until DMA is done with the next buffer and return it for rendering.
+    // The core sleeps (WFE) until the completion IRQ instead of spinning on the FIFO.
+    uint32_t* acquireBuffer() {
+        while (!bufferFree[nextBuffer]) {
+            __wfe();
+        }
+
+        return dmaBuffers[nextBuffer];
+    }
+
+    // Hand the buffer returned by acquireBuffer() back to DMA
+    void submitBuffer() {
+        bufferFree[nextBuffer] = false;
+        nextBuffer = 1 - nextBuffer;
+    }
+
+    // Zero both buffers, e.g. while the rendering core is parked (any core).
+    // DMA keeps looping them, so the DAC plays silence until the next block.
+    void silenceDma() {
+        if (!dmaRunning) {
+            return;
+        }
+        for (int i = 0; i < 2; i++) {
+            memset(dmaBuffers[i], 0, dmaFrames * sizeof(uint32_t));
+        }
+    }
+
+    // Number of blocks DMA had to replay because they were not rendered in time
+    uint32_t getUnderruns() const {
+        return underruns;
     }
 
     uint32_t getSampleRate() const {
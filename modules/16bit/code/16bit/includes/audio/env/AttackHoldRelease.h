@@ -133,11 +133,19 @@ class AttackHoldReleaseEnvelope : public Envelope {
                     break;
             }
             
-            
+            level = currentLevel;
             return sample * currentLevel;
         }
 
         bool isActive() override {
             return currentState != IDLE;
         }
+
+        void reset() override {
+            currentState = IDLE;
+            isTriggered = false;
+            currentTime = 0;
+            triggerAtZero = false;
+            level = 0.0f;
+        }
 };
\ No newline at end of file
@@ -118,11 +118,18 @@ class AttackReleaseEnvelope : public Envelope {
                     break;
             }
             
-            
+            level = currentLevel;
             return sample * currentLevel;
         }
 
         bool isActive() override {
             return currentState != IDLE;
         }
+
+        void reset() override {
+            currentState = IDLE;
+            currentTime = 0;
+            triggerAtZero = false;
+            level = 0.0f;
+        }
 };
\ No newline at end of file
@@ -6,6 +6,8 @@
 class Envelope {
 protected:
     std::function<void()> onCompleteCallback = nullptr;
+    // Gain applied by the last process() call
+    float level = 0.0f;
 
 public:
     virtual ~Envelope() = default;
@@ -24,6 +26,13 @@ public:
 
     virtual bool isActive() = 0;
 
+    // Back to idle right away, without firing the complete callback
+    virtual void reset() = 0;
+
+    float getLevel() const {
+        return level;
+    }
+
     // Set the callback function to be called when the envelope is complete
     void setOnCompleteCallback(std::function<void()> callback) {
         this->onCompleteCallback = callback;
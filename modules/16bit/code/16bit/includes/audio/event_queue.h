@@ -0,0 +1,85 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+// Capacity of the core0 -> core1 event queue (power of two).
+// A full MIDI burst (a 10-note chord plus CCs) is well under this.
+#ifndef AUDIO_EVENT_QUEUE_SIZE
+#define AUDIO_EVENT_QUEUE_SIZE 64
+#endif
+
+enum AudioEventType : uint8_t {
+    AUDIO_EVENT_NOTE_ON,
+    AUDIO_EVENT_NOTE_OFF,
+    AUDIO_EVENT_CC,
+    AUDIO_EVENT_CV1,
+    AUDIO_EVENT_CV2,
+    AUDIO_EVENT_BPM,
+    AUDIO_EVENT_PITCH_BEND,
+    // Run `fn(context, arg)` on the audio core, e.g. to set a parameter
+    // or swap an FX without racing the render loop
+    AUDIO_EVENT_CALL,
+};
+
+typedef void (*AudioEventFn)(void* context, int32_t arg);
+
+typedef struct {
+    uint32_t frame;      // Audio frame the event is due at (see AudioManager::now())
+    AudioEventType type;
+    uint8_t channel;
+    uint8_t data1;       // Note or CC number
+    uint8_t data2;       // Velocity or CC value
+    uint16_t value;      // CV reading, BPM or pitch bend (0..16383)
+    int32_t arg;
+    AudioEventFn fn;
+    void* context;
+} AudioEvent;
+
+// Wait-free single-producer/single-consumer ring buffer.
+// One core pushes, the other pops; neither ever blocks or takes a lock.
+// Each index is only written by its owner, and the release/acquire pair
+// makes the slot contents visible before the index that publishes them.
+template <typename T, size_t CAPACITY>
+class SpscQueue {
+    static_assert((CAPACITY & (CAPACITY - 1)) == 0, "SpscQueue capacity must be a power of two");
+
+private:
+    T items[CAPACITY];
+    std::atomic<uint32_t> head{0}; // Next slot to pop (consumer)
+    std::atomic<uint32_t> tail{0}; // Next slot to push (producer)
+
+public:
+    // Producer only. Returns false if the queue is full.
+    bool push(const T& item) {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) >= CAPACITY) {
+            return false;
+        }
+        items[t & (CAPACITY - 1)] = item;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only. Oldest item, or nullptr if the queue is empty.
+    // The item stays valid until pop().
+    const T* peek() const {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        return &items[h & (CAPACITY - 1)];
+    }
+
+    // Consumer only. Drops the item returned by peek().
+    void pop() {
+        head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // Only while neither side is running (e.g. core1 is reset)
+    void clear() {
+        head.store(0, std::memory_order_relaxed);
+        tail.store(0, std::memory_order_relaxed);
+    }
+};
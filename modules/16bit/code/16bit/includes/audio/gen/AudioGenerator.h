@@ -2,14 +2,30 @@
 
 #include "audio/manager.h"
 
+// Oscillators run a 32-bit phase accumulator: one full cycle is 2^32, and
+// unsigned overflow wraps the phase for free. The increment carries the
+// frequency with ~0.00001 Hz resolution at 44.1kHz, so every note is in tune.
 class AudioGenerator {
+protected:
+    uint32_t sampleRate = 48000;
+    uint32_t phase = 0;
+    uint32_t phaseIncrement = 0;
+
 public:
+    virtual ~AudioGenerator() = default;
+
+    virtual void init(AudioManager *audioManager) {
+        sampleRate = audioManager->getDac()->getSampleRate();
+    }
 
-    virtual void init(AudioManager *audioManager) = 0;
-    
-    virtual void setFrequency(uint16_t frequency) = 0;
+    // Takes effect on the next sample, keeping the phase continuous
+    virtual void setFrequency(float frequency) {
+        phaseIncrement = (uint32_t)(frequency * (4294967296.0f / sampleRate));
+    }
 
-    virtual void reset() = 0;
+    virtual void reset() {
+        phase = 0;
+    }
 
     virtual float getSample() = 0;
 };
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "pico/stdlib.h"
+#include "audio/manager.h"
+#include "./AudioGenerator.h"
+#include "./PolyBlep.h"
+
+// Band-limited saw: the naive ramp with its reset smoothed by PolyBLEP
+class BlepSaw: public AudioGenerator {
+    private:
+        float dt = 0.0f;
+
+    public:
+        BlepSaw() {}
+
+        void setFrequency(float frequency) override {
+            AudioGenerator::setFrequency(frequency);
+            dt = phaseToFloat(phaseIncrement);
+        }
+
+        static inline float kernel(uint32_t phase, float dt) {
+            float t = phaseToFloat(phase);
+            return t + t - 1.0f - polyBlep(t, dt);
+        }
+
+        float getSample() override {
+            float amplitude = kernel(phase, dt);
+            phase += phaseIncrement;
+
+            return amplitude;
+        }
+};
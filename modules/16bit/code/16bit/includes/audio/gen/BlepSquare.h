@@ -0,0 +1,48 @@
+#pragma once
+
+#include "pico/stdlib.h"
+#include "audio/manager.h"
+#include "./AudioGenerator.h"
+#include "./PolyBlep.h"
+
+// Band-limited pulse: both edges smoothed by PolyBLEP
+class BlepSquare: public AudioGenerator {
+    private:
+        float dt = 0.0f;
+        uint8_t pulseWidth = 50; // Pulse width in percentage (50% = square wave)
+        uint32_t pulseThreshold = 0x80000000u;
+
+    public:
+        BlepSquare() {}
+
+        void setFrequency(float frequency) override {
+            AudioGenerator::setFrequency(frequency);
+            dt = phaseToFloat(phaseIncrement);
+        }
+
+        void setPulseWidth(uint8_t width) {
+            // Ensure pulse width is between 5% and 95%
+            pulseWidth = (width < 5) ? 5 : ((width > 95) ? 95 : width);
+            pulseThreshold = (uint32_t)(pulseWidth * (4294967296.0 / 100.0));
+        }
+
+        static inline float pulse(uint32_t phase, float dt, uint32_t threshold) {
+            float amplitude = (phase < threshold) ? 1.0f : -1.0f;
+            // Rising edge at phase 0, falling edge at the threshold. The
+            // unsigned subtraction wraps the phase around the falling edge.
+            amplitude += polyBlep(phaseToFloat(phase), dt);
+            amplitude -= polyBlep(phaseToFloat(phase - threshold), dt);
+            return amplitude;
+        }
+
+        static inline float kernel(uint32_t phase, float dt) {
+            return pulse(phase, dt, 0x80000000u);
+        }
+
+        float getSample() override {
+            float amplitude = pulse(phase, dt, pulseThreshold);
+            phase += phaseIncrement;
+
+            return amplitude;
+        }
+};
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "pico/stdlib.h"
+#include "audio/manager.h"
+#include "./AudioGenerator.h"
+#include "./PolyBlep.h"
+
+// Band-limited triangle: the naive fold with both peaks smoothed by PolyBLAMP
+class BlepTri: public AudioGenerator {
+    private:
+        float dt = 0.0f;
+
+    public:
+        BlepTri() {}
+
+        void setFrequency(float frequency) override {
+            AudioGenerator::setFrequency(frequency);
+            dt = phaseToFloat(phaseIncrement);
+        }
+
+        static inline float kernel(uint32_t phase, float dt) {
+            uint32_t folded = (phase < 0x80000000u) ? phase : ~phase;
+            float amplitude = folded * (2.0f / 2147483648.0f) - 1.0f;
+
+            // The slope flips by 8 per cycle (+4 to -4) at each peak, that's
+            // 8 * dt per sample, or 4 * dt of polyBlamp's slope change of 2
+            float blampScale = 4.0f * dt;
+            amplitude += blampScale * polyBlamp(phaseToFloat(phase), dt);
+            amplitude -= blampScale * polyBlamp(phaseToFloat(phase + 0x80000000u), dt);
+            return amplitude;
+        }
+
+        float getSample() override {
+            float amplitude = kernel(phase, dt);
+            phase += phaseIncrement;
+
+            return amplitude;
+        }
+};
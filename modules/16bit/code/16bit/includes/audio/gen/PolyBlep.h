@@ -0,0 +1,36 @@
+#pragma once
+
+// Correction terms for band-limited oscillators.
+// A naive waveform has hard corners that alias at 44.1kHz. PolyBLEP smooths a
+// step (saw reset, square edge) and PolyBLAMP a slope change (triangle peak)
+// with a short polynomial over the sample on each side of the discontinuity.
+// t is the phase (0..1) relative to the discontinuity, dt the phase increment.
+
+// Residual of a -1 to +1 step (a jump of 2)
+static inline float polyBlep(float t, float dt) {
+    if (t < dt) {
+        t /= dt;
+        return t + t - t * t - 1.0f;
+    } else if (t > 1.0f - dt) {
+        t = (t - 1.0f) / dt;
+        return t * t + t + t + 1.0f;
+    }
+    return 0.0f;
+}
+
+// Residual of a slope change of 2 per sample, the integral of polyBlep
+static inline float polyBlamp(float t, float dt) {
+    if (t < dt) {
+        t = t / dt - 1.0f;
+        return -(1.0f / 3.0f) * t * t * t;
+    } else if (t > 1.0f - dt) {
+        t = (t - 1.0f) / dt + 1.0f;
+        return (1.0f / 3.0f) * t * t * t;
+    }
+    return 0.0f;
+}
+
+// Phase accumulator value as 0..1
+static inline float phaseToFloat(uint32_t phase) {
+    return phase * (1.0f / 4294967296.0f);
+}
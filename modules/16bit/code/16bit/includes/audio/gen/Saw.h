@@ -5,38 +5,20 @@
 #include "./AudioGenerator.h"
 
 class Saw: public AudioGenerator {
-    private:
-        uint32_t sampleRate = 48000;
-        uint16_t sampleId = 0;
-        uint16_t samplesPerCycle = 0;
-        uint16_t nextSamplesPerCycle = 0;
-
     public:
         Saw() {}
 
-        void setFrequency(uint16_t frequency) {
-            nextSamplesPerCycle = sampleRate / frequency;
-        }
-
-        void init(AudioManager* audioManager) {
-            sampleRate = audioManager->getDac()->getSampleRate();
-        }
-
-        void reset() {
-            sampleId = 0;
+        // One sample at `phase`; dt (the increment as 0..1) is unused here.
+        // Static so VoiceEngine can run it without a virtual call.
+        static inline float kernel(uint32_t phase, float dt) {
+            // Phase 0 to 2^32 maps to amplitude -1.0 to 1.0
+            return phase * (2.0f / 4294967296.0f) - 1.0f;
         }
 
         float getSample() {
-            if (sampleId == 0 && nextSamplesPerCycle != samplesPerCycle) {
-                samplesPerCycle = nextSamplesPerCycle;
-            }
-        
-            // Sawtooth wave generation using integer math
-            // Maps sampleId from 0 to samplesPerCycle to amplitude -32768 to 32767
-            float amplitude = ((sampleId * 2.0f) / samplesPerCycle) - 1.0f;
-
-            sampleId = (sampleId + 1) % samplesPerCycle;
+            float amplitude = kernel(phase, 0.0f);
+            phase += phaseIncrement;
 
             return amplitude;
         }
-};
\ No newline at end of file
+};
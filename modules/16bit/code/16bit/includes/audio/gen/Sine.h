@@ -5,40 +5,49 @@
 #include "audio/manager.h"
 #include "./AudioGenerator.h"
 
+// One sine cycle, plus a guard point so interpolation never wraps.
+// With linear interpolation 512 points keep the error below -90dB.
+#define SINE_TABLE_BITS 9
+#define SINE_TABLE_SIZE (1 << SINE_TABLE_BITS)
+
+float sineTable[SINE_TABLE_SIZE + 1];
+bool sineTableReady = false;
+
 class Sine: public AudioGenerator {
     private:
-        uint32_t sampleRate = 48000;
-        uint16_t sampleId = 0;
-        uint16_t samplesPerCycle = 0;
-        uint16_t nextSamplesPerCycle = 0;
+        static constexpr uint32_t FRACTION_BITS = 32 - SINE_TABLE_BITS;
 
     public:
         Sine() {}
 
-        void setFrequency(uint16_t freqency) {
-            nextSamplesPerCycle = sampleRate / freqency;
+        static void initTable() {
+            if (!sineTableReady) {
+                for (int i = 0; i <= SINE_TABLE_SIZE; i++) {
+                    sineTable[i] = sinf(2.0f * (float)M_PI * i / SINE_TABLE_SIZE);
+                }
+                sineTableReady = true;
+            }
         }
 
         void init(AudioManager* audioManager) {
-            sampleRate = audioManager->getDac()->getSampleRate();
+            AudioGenerator::init(audioManager);
+            initTable();
         }
 
-        void reset() {
-            sampleId = 0;
+        // Needs initTable() first
+        static inline float kernel(uint32_t phase, float dt) {
+            uint32_t index = phase >> FRACTION_BITS;
+            float fraction = (phase & ((1u << FRACTION_BITS) - 1)) * (1.0f / (1u << FRACTION_BITS));
+            float a = sineTable[index];
+            float b = sineTable[index + 1];
+
+            return a + (b - a) * fraction;
         }
 
         float getSample() {
-            if (sampleId == 0 && nextSamplesPerCycle != samplesPerCycle) {
-                samplesPerCycle = nextSamplesPerCycle;
-            }
-        
-            // Just a sine wave for now
-            float phase = samplesPerCycle == 0 ? 0.0f : sampleId / (float)samplesPerCycle;
-            phase = phase > 1.0 ? 1.0 : phase;
-            float angle = 2.0f * M_PI * phase;
-
-            sampleId = (sampleId + 1) % samplesPerCycle;
+            float amplitude = kernel(phase, 0.0f);
+            phase += phaseIncrement;
 
-            return sin(angle);
+            return amplitude;
         }
-};
\ No newline at end of file
+};
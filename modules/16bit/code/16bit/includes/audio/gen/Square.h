@@ -6,45 +6,31 @@
 
 class Square: public AudioGenerator {
     private:
-        uint32_t sampleRate = 48000;
-        uint16_t sampleId = 0;
-        uint16_t samplesPerCycle = 0;
-        uint16_t nextSamplesPerCycle = 0;
         uint8_t pulseWidth = 50; // Pulse width in percentage (50% = square wave)
+        uint32_t pulseThreshold = 0x80000000u;
 
     public:
         Square() {}
 
-        void setFrequency(uint16_t frequency) {
-            nextSamplesPerCycle = sampleRate / frequency;
-        }
-
         void setPulseWidth(uint8_t width) {
             // Ensure pulse width is between 5% and 95%
             pulseWidth = (width < 5) ? 5 : ((width > 95) ? 95 : width);
+            pulseThreshold = (uint32_t)(pulseWidth * (4294967296.0 / 100.0));
         }
 
-        void init(AudioManager* audioManager) {
-            sampleRate = audioManager->getDac()->getSampleRate();
+        static inline float pulse(uint32_t phase, uint32_t threshold) {
+            // Output full positive amplitude for pulse width duration, then full negative amplitude
+            return (phase < threshold) ? 1.0f : -1.0f;
         }
 
-        void reset() {
-            sampleId = 0;
+        static inline float kernel(uint32_t phase, float dt) {
+            return pulse(phase, 0x80000000u);
         }
 
         float getSample() {
-            if (sampleId == 0 && nextSamplesPerCycle != samplesPerCycle) {
-                samplesPerCycle = nextSamplesPerCycle;
-            }
-            
-            // Square wave generation using integer math
-            uint32_t thresholdSample = (samplesPerCycle * pulseWidth) / 100;
-            
-            // Output full positive amplitude for pulse width duration, then full negative amplitude
-            float amplitude = (sampleId < thresholdSample) ? 1.0f : -1.0f;
-            
-            sampleId = (sampleId + 1) % samplesPerCycle;
+            float amplitude = pulse(phase, pulseThreshold);
+            phase += phaseIncrement;
 
             return amplitude;
         }
-};
\ No newline at end of file
+};
@@ -0,0 +1,375 @@
+#pragma once
+
+#include <stdio.h>
+#include <atomic>
+#include <algorithm>
+#include "pico/stdlib.h"
+#include "audio/manager.h"
+#include "audio/tools/fft.h"
+#include "fs/pico_lfs.h"
+#include "psram.h"
+#include "./AudioGenerator.h"
+
+// Wavetables live in /wavetables/NN.wt as raw little-endian int16 frames of
+// WAVETABLE_FRAME_SIZE samples each (one cycle per frame). A single-frame file
+// is a plain single-cycle waveform; more frames can be morphed through.
+#define WAVETABLE_FRAME_BITS 11
+#define WAVETABLE_FRAME_SIZE (1 << WAVETABLE_FRAME_BITS)
+#define WAVETABLE_MAX_FRAMES 64
+#define WAVETABLE_SLOTS 16
+
+// Mip level L keeps the lowest (WAVETABLE_FRAME_SIZE / 2) >> L harmonics, so
+// there is one level per octave down to a pure sine. Each level is stored at
+// 4x its top harmonic (at least 64 samples) to keep interpolation clean.
+#define WAVETABLE_MIP_LEVELS WAVETABLE_FRAME_BITS
+#define WAVETABLE_MIN_LEVEL_BITS 6
+
+// Largest mip level a voice copies into SRAM. The bigger levels only play
+// below ~86Hz, where the phase crawls through the table and the XIP cache
+// already covers the PSRAM reads.
+#define WAVETABLE_CACHE_SIZE 512
+
+// Frames are normalised to this peak, leaving room for the Gibbs overshoot
+// of band-limited edges
+#define WAVETABLE_HEADROOM 0.9f
+
+class WavetableBank;
+WavetableBank* wavetable_bank_instance = nullptr;
+
+// The loaded wavetable: every frame as a set of band-limited mip levels in
+// PSRAM. Built once on load (core0, audio stopped), shared by all voices.
+class WavetableBank {
+    private:
+        int16_t* data = nullptr;
+        uint16_t frames = 0;
+        uint32_t frameStride = 0;
+        uint32_t levelOffset[WAVETABLE_MIP_LEVELS];
+        int8_t slot = -1;
+
+        WavetableBank() {
+            uint32_t offset = 0;
+            for (uint8_t level = 0; level < WAVETABLE_MIP_LEVELS; level++) {
+                levelOffset[level] = offset;
+                // Plus a guard point so interpolation never wraps
+                offset += levelSize(level) + 1;
+            }
+            frameStride = offset;
+        }
+
+        // Band-limit every frame (its raw samples sit in the level 0 area)
+        // into all the mip levels
+        void buildLevels(int32_t peak) {
+            FFT fft(WAVETABLE_FRAME_SIZE);
+            float* spectrumRe = new float[WAVETABLE_FRAME_SIZE];
+            float* spectrumIm = new float[WAVETABLE_FRAME_SIZE];
+            float* re = new float[WAVETABLE_FRAME_SIZE];
+            float* im = new float[WAVETABLE_FRAME_SIZE];
+
+            const float gain = peak > 0 ? WAVETABLE_HEADROOM * 32767.0f / ((float)peak * WAVETABLE_FRAME_SIZE) : 0.0f;
+
+            for (uint16_t frame = 0; frame < frames; frame++) {
+                int16_t* base = data + frame * frameStride;
+                for (uint32_t i = 0; i < WAVETABLE_FRAME_SIZE; i++) {
+                    spectrumRe[i] = base[i];
+                    spectrumIm[i] = 0.0f;
+                }
+                fft.transform(spectrumRe, spectrumIm, WAVETABLE_FRAME_SIZE, false);
+
+                for (uint8_t level = 0; level < WAVETABLE_MIP_LEVELS; level++) {
+                    uint32_t size = levelSize(level);
+                    uint32_t top = harmonics(level);
+                    std::fill(re, re + size, 0.0f);
+                    std::fill(im, im + size, 0.0f);
+
+                    // DC is dropped; negative frequencies mirror the positive ones
+                    for (uint32_t k = 1; k <= top; k++) {
+                        re[k] = spectrumRe[k];
+                        if (k < size / 2) {
+                            im[k] = spectrumIm[k];
+                            re[size - k] = spectrumRe[k];
+                            im[size - k] = -spectrumIm[k];
+                        }
+                    }
+                    fft.transform(re, im, size, true);
+
+                    int16_t* table = base + levelOffset[level];
+                    for (uint32_t i = 0; i < size; i++) {
+                        table[i] = (int16_t)std::clamp(re[i] * gain, -32768.0f, 32767.0f);
+                    }
+                    table[size] = table[0];
+                }
+            }
+
+            delete[] spectrumRe;
+            delete[] spectrumIm;
+            delete[] re;
+            delete[] im;
+        }
+
+    public:
+        static WavetableBank* getInstance() {
+            if (wavetable_bank_instance == nullptr) {
+                wavetable_bank_instance = new WavetableBank();
+            }
+            return wavetable_bank_instance;
+        }
+
+        static constexpr uint32_t harmonics(uint8_t level) {
+            return (WAVETABLE_FRAME_SIZE / 2) >> level;
+        }
+
+        static constexpr uint8_t levelBits(uint8_t level) {
+            return WAVETABLE_FRAME_BITS + 1 - level > WAVETABLE_FRAME_BITS ? WAVETABLE_FRAME_BITS
+                 : WAVETABLE_FRAME_BITS + 1 - level < WAVETABLE_MIN_LEVEL_BITS ? WAVETABLE_MIN_LEVEL_BITS
+                 : WAVETABLE_FRAME_BITS + 1 - level;
+        }
+
+        static constexpr uint32_t levelSize(uint8_t level) {
+            return 1u << levelBits(level);
+        }
+
+        // Lowest level whose harmonics all stay below Nyquist: harmonic H at
+        // a phase increment of `increment` is fine while H * increment <= 2^31
+        static uint8_t levelForIncrement(uint32_t increment) {
+            if (increment <= (1u << (32 - WAVETABLE_FRAME_BITS))) {
+                return 0;
+            }
+            uint32_t level = (32 - __builtin_clz(increment - 1)) - (32 - WAVETABLE_FRAME_BITS);
+            return MIN(level, (uint32_t)WAVETABLE_MIP_LEVELS - 1);
+        }
+
+        static bool saveWavetable(uint8_t slot, uint8_t* data, int size) {
+            char path[32];
+            snprintf(path, sizeof(path), "/wavetables/%02d.wt", slot);
+            return write_file(path, data + 4, size);
+        }
+
+        // Load a slot into PSRAM. A missing or empty file loads a saw, so
+        // the voices have something to play unless PSRAM is full (then
+        // getFrames() is 0). Core0, audio stopped.
+        bool load(uint8_t slot) {
+            PSRAM* psram = PSRAM::getInstance();
+            char path[32];
+            snprintf(path, sizeof(path), "/wavetables/%02d.wt", slot);
+            size_t fileSize = get_file_size(path);
+
+            frames = MIN(fileSize / (WAVETABLE_FRAME_SIZE * sizeof(int16_t)), (size_t)WAVETABLE_MAX_FRAMES);
+            bool fromFile = frames > 0;
+            if (!fromFile) {
+                frames = 1;
+            }
+
+            this->slot = slot;
+            // Replaces the previous slot's tables rather than leaking them
+            psram->free(data);
+            data = (int16_t*)psram->alloc(frames * frameStride * sizeof(int16_t), PSRAM_ARENA_SAMPLES);
+            if (data == nullptr) {
+                // No room for the file: fall back to the one-frame saw
+                frames = 1;
+                fromFile = false;
+                data = (int16_t*)psram->alloc(frameStride * sizeof(int16_t), PSRAM_ARENA_SAMPLES);
+                if (data == nullptr) {
+                    // Not even that: no frames, and the voices stay silent
+                    printf("No PSRAM for wavetable %02d\n", slot);
+                    frames = 0;
+                    return false;
+                }
+            }
+
+            // Raw frames go straight into the level 0 areas, then get
+            // band-limited in place
+            int32_t peak = 0;
+            lfs_file_t file;
+            if (fromFile && lfs_file_open(&lfs, &file, path, LFS_O_RDONLY) == 0) {
+                for (uint16_t frame = 0; frame < frames; frame++) {
+                    int16_t* base = data + frame * frameStride;
+                    size_t bytesRead = 0;
+                    if (!read_file_chunk(&file, base, WAVETABLE_FRAME_SIZE * sizeof(int16_t), &bytesRead) ||
+                        bytesRead != WAVETABLE_FRAME_SIZE * sizeof(int16_t)) {
+                        // Keep the complete frames, if any
+                        fromFile = frame > 0;
+                        frames = MAX(1, frame);
+                        break;
+                    }
+                    for (uint32_t i = 0; i < WAVETABLE_FRAME_SIZE; i++) {
+                        peak = MAX(peak, abs(base[i]));
+                    }
+                }
+                lfs_file_close(&lfs, &file);
+            } else {
+                fromFile = false;
+            }
+
+            if (!fromFile) {
+                printf("Wavetable %02d not found, loading a saw\n", slot);
+                for (uint32_t i = 0; i < WAVETABLE_FRAME_SIZE; i++) {
+                    data[i] = (int16_t)(-32767 + (int32_t)(65534 * i / WAVETABLE_FRAME_SIZE));
+                }
+                peak = 32767;
+            }
+
+            buildLevels(peak);
+            return fromFile;
+        }
+
+        int8_t getSlot() const {
+            return slot;
+        }
+
+        uint16_t getFrames() const {
+            return frames;
+        }
+
+        const int16_t* table(uint16_t frame, uint8_t level) const {
+            return data + frame * frameStride + levelOffset[level];
+        }
+};
+
+// Wavetable oscillator: linear interpolation within the mip level that suits
+// the note, and between two neighbouring frames for morphing. Each voice has
+// its own morph position.
+//
+// The audio core reads the two active tables from an SRAM cache when it holds
+// them and straight from PSRAM otherwise. updateCache() (core0) refills the
+// cache when the note or morph moves to other tables: it writes the line the
+// audio core isn't using, then publishes it. A line is only reused once the
+// audio core has switched to the newest one, so neither core ever waits.
+class Wavetable final: public AudioGenerator {
+    private:
+        struct CacheLine {
+            uint8_t level;
+            uint16_t frame;
+            int16_t samples[2][WAVETABLE_CACHE_SIZE + 1];
+        };
+
+        WavetableBank* bank = nullptr;
+
+        // What the voice plays, set on the audio core and read by updateCache()
+        volatile uint8_t level = 0;
+        volatile uint16_t frame = 0;
+        uint32_t indexShift = 32 - WAVETABLE_FRAME_BITS;
+        float morph = 0.0f;
+        float morphFraction = 0.0f;
+
+        CacheLine cache[2];
+        std::atomic<int8_t> publishedLine{-1}; // Written by core0
+        std::atomic<int8_t> readingLine{-1};   // Written by the audio core
+        int8_t lastLine = -1;
+
+        // The two frames being played, from the cache or PSRAM (audio core)
+        const int16_t* tableA = nullptr;
+        const int16_t* tableB = nullptr;
+
+        uint16_t lastFrame() const {
+            return bank->getFrames() > 0 ? bank->getFrames() - 1 : 0;
+        }
+
+        uint16_t nextFrame(uint16_t frame) const {
+            return MIN(frame + 1, lastFrame());
+        }
+
+        void updateFramePosition() {
+            float position = morph * lastFrame();
+            uint16_t index = MIN((uint16_t)position, lastFrame());
+            morphFraction = position - index;
+            frame = index;
+        }
+
+        // Audio core: point at the cache line if it holds what the voice
+        // plays now, or at PSRAM until core0 has copied it
+        void selectTables() {
+            if (lastLine >= 0 && cache[lastLine].level == level && cache[lastLine].frame == frame) {
+                tableA = cache[lastLine].samples[0];
+                tableB = cache[lastLine].samples[1];
+            } else if (bank->getFrames() > 0) {
+                tableA = bank->table(frame, level);
+                tableB = bank->table(nextFrame(frame), level);
+            } else {
+                tableA = tableB = nullptr;
+            }
+        }
+
+    public:
+        Wavetable() {}
+
+        // Call again after the bank loads another slot
+        void init(AudioManager* audioManager) {
+            AudioGenerator::init(audioManager);
+            bank = WavetableBank::getInstance();
+            publishedLine.store(-1);
+            readingLine.store(-1);
+            lastLine = -1;
+            updateFramePosition();
+            selectTables();
+        }
+
+        void setFrequency(float frequency) {
+            AudioGenerator::setFrequency(frequency);
+            uint8_t newLevel = WavetableBank::levelForIncrement(phaseIncrement);
+            indexShift = 32 - WavetableBank::levelBits(newLevel);
+            level = newLevel;
+            selectTables();
+        }
+
+        // 0 plays the first frame, 1 the last one
+        void setMorph(float position) {
+            morph = std::clamp(position, 0.0f, 1.0f);
+            updateFramePosition();
+            selectTables();
+        }
+
+        float getMorph() const {
+            return morph;
+        }
+
+        // False while the bank has no data: don't call getSample()
+        bool hasTables() const {
+            return tableA != nullptr;
+        }
+
+        __attribute__((hot)) float getSample() {
+            int8_t line = publishedLine.load(std::memory_order_acquire);
+            if (line != lastLine) {
+                readingLine.store(line, std::memory_order_release);
+                lastLine = line;
+                selectTables();
+            }
+
+            uint32_t index = phase >> indexShift;
+            float fraction = (float)(phase << (32 - indexShift)) * (1.0f / 4294967296.0f);
+            phase += phaseIncrement;
+
+            const int16_t* a = tableA;
+            const int16_t* b = tableB;
+            float x = a[index] + (a[index + 1] - a[index]) * fraction;
+            float y = b[index] + (b[index + 1] - b[index]) * fraction;
+            return (x + (y - x) * morphFraction) * (1.0f / 32768.0f);
+        }
+
+        // Core0: bring the tables the voice is playing into SRAM
+        void updateCache() {
+            uint8_t wantLevel = level;
+            uint16_t wantFrame = frame;
+            uint32_t size = WavetableBank::levelSize(wantLevel);
+            if (size > WAVETABLE_CACHE_SIZE || bank->getFrames() == 0) {
+                return;
+            }
+
+            int8_t published = publishedLine.load(std::memory_order_relaxed);
+            if (published >= 0 && cache[published].level == wantLevel && cache[published].frame == wantFrame) {
+                return;
+            }
+            // The audio core may still be reading the other line; retry on the next update
+            if (readingLine.load(std::memory_order_acquire) != published) {
+                return;
+            }
+
+            int8_t line = published == 0 ? 1 : 0;
+            CacheLine& entry = cache[line];
+            std::copy_n(bank->table(wantFrame, wantLevel), size + 1, entry.samples[0]);
+            std::copy_n(bank->table(nextFrame(wantFrame), wantLevel), size + 1, entry.samples[1]);
+            entry.level = wantLevel;
+            entry.frame = wantFrame;
+            publishedLine.store(line, std::memory_order_release);
+        }
+};
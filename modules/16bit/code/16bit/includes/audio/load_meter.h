@@ -0,0 +1,144 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include "pico/stdlib.h"
+#include "hardware/clocks.h"
+#include "hardware/sync.h"
+#include "hardware/structs/m33.h"
+
+// Load histogram resolution: one bin per percent of the block period,
+// everything at or above LOAD_METER_MAX_PERCENT lands in the last bin.
+#define LOAD_METER_MAX_PERCENT 200
+
+// Render-time statistics over one window (about a second of audio).
+// Times are in CPU cycles; budgetCycles is one block period.
+typedef struct {
+    uint32_t budgetCycles;
+    uint32_t minCycles;
+    uint32_t avgCycles;
+    uint32_t p99Cycles;
+    uint32_t maxCycles;
+    uint32_t windowBlocks;
+    uint32_t totalBlocks;
+    uint32_t overruns;
+} AudioLoadStats;
+
+// Measures how long each audio block takes to render, using the Cortex-M33
+// DWT cycle counter. begin()/end() run on core1 around every block; the stats
+// are published once per window and can be read from core0 at any time.
+class AudioLoadMeter {
+private:
+    uint32_t budgetCycles = 1;
+    uint32_t blocksPerWindow = 1;
+
+    // Current window (core1 only)
+    uint16_t histogram[LOAD_METER_MAX_PERCENT + 1];
+    uint32_t windowBlocks = 0;
+    uint64_t windowCycles = 0;
+    uint32_t windowMin = UINT32_MAX;
+    uint32_t windowMax = 0;
+
+    uint32_t totalBlocks = 0;
+    uint32_t overruns = 0;
+
+    // Last published window, guarded by a sequence counter: odd while core1
+    // is writing, so readers retry instead of seeing a torn snapshot.
+    volatile uint32_t sequence = 0;
+    AudioLoadStats published = {};
+
+    void publish() {
+        // Walk the histogram up to the 99th percentile block
+        uint32_t rank = windowBlocks - windowBlocks / 100;
+        uint32_t seen = 0;
+        uint32_t p99Percent = LOAD_METER_MAX_PERCENT;
+        for (uint32_t i = 0; i <= LOAD_METER_MAX_PERCENT; i++) {
+            seen += histogram[i];
+            if (seen >= rank) {
+                p99Percent = i + 1;
+                break;
+            }
+        }
+
+        sequence++;
+        __dmb();
+        published.budgetCycles = budgetCycles;
+        published.minCycles = windowMin;
+        published.avgCycles = (uint32_t)(windowCycles / windowBlocks);
+        // Upper edge of the bin, but never above the worst block we saw
+        published.p99Cycles = std::min((uint32_t)((uint64_t)budgetCycles * p99Percent / 100), windowMax);
+        published.maxCycles = windowMax;
+        published.windowBlocks = windowBlocks;
+        published.totalBlocks = totalBlocks;
+        published.overruns = overruns;
+        __dmb();
+        sequence++;
+
+        resetWindow();
+    }
+
+    void resetWindow() {
+        memset(histogram, 0, sizeof(histogram));
+        windowBlocks = 0;
+        windowCycles = 0;
+        windowMin = UINT32_MAX;
+        windowMax = 0;
+    }
+
+public:
+    AudioLoadMeter() {
+        resetWindow();
+    }
+
+    // Must run on the core being measured: the DWT is per core.
+    void init(uint32_t sampleRate, uint32_t blockSize) {
+        m33_hw->demcr |= M33_DEMCR_TRCENA_BITS;
+        m33_hw->dwt_ctrl |= M33_DWT_CTRL_CYCCNTENA_BITS;
+
+        budgetCycles = (uint32_t)((uint64_t)clock_get_hz(clk_sys) * blockSize / sampleRate);
+        blocksPerWindow = sampleRate / blockSize;
+        totalBlocks = 0;
+        overruns = 0;
+        resetWindow();
+    }
+
+    static inline uint32_t begin() {
+        return m33_hw->dwt_cyccnt;
+    }
+
+    // A block that takes longer than its own playback time is an overrun:
+    // it's eating into the slack of the DMA buffer (or starving the FIFO).
+    inline void end(uint32_t startCycles) {
+        uint32_t cycles = m33_hw->dwt_cyccnt - startCycles;
+
+        uint32_t percent = (uint32_t)((uint64_t)cycles * 100 / budgetCycles);
+        histogram[percent < LOAD_METER_MAX_PERCENT ? percent : LOAD_METER_MAX_PERCENT]++;
+        windowCycles += cycles;
+        windowMin = cycles < windowMin ? cycles : windowMin;
+        windowMax = cycles > windowMax ? cycles : windowMax;
+        windowBlocks++;
+        totalBlocks++;
+        if (cycles > budgetCycles) {
+            overruns++;
+        }
+
+        if (windowBlocks >= blocksPerWindow) {
+            publish();
+        }
+    }
+
+    // Copy of the last complete window. windowBlocks is 0 until the first
+    // window has been measured.
+    AudioLoadStats getStats() const {
+        AudioLoadStats stats;
+        uint32_t before;
+        do {
+            before = sequence;
+            __dmb();
+            stats = published;
+            __dmb();
+        } while ((before & 1) || before != sequence);
+        return stats;
+    }
+};
@@ -7,13 +7,28 @@
 #include "pico/multicore.h"
 #include "pico/util/queue.h"
 #include "audio/dac.h"
+#include "audio/load_meter.h"
+#include "audio/event_queue.h"
+#include "audio/adc_capture.h"
+#include "fs/pico_lfs.h"
 #include "hardware/clocks.h"
-#include "hardware/adc.h"
 #include <functional>
 
 #define BCK_PIN 1
-#define A0 0
-#define A1 1
+
+// Number of frames rendered per audio callback.
+// Larger blocks amortize the callback overhead, smaller ones lower the latency.
+#ifndef AUDIO_BLOCK_SIZE
+#define AUDIO_BLOCK_SIZE 32
+#endif
+
+static_assert(AUDIO_BLOCK_SIZE == 16 || AUDIO_BLOCK_SIZE == 32 || AUDIO_BLOCK_SIZE == 64,
+              "AUDIO_BLOCK_SIZE must be 16, 32 or 64 frames");
+
+// Feed the DAC from DMA ping-pong buffers instead of blocking FIFO writes
+#ifndef AUDIO_OUTPUT_DMA
+#define AUDIO_OUTPUT_DMA 1
+#endif
 
 typedef struct {
     float left;
@@ -25,15 +40,15 @@ typedef struct {
     float right;
 } AudioOutput;
 
-typedef void (*AudioCallbackFn)(AudioInput* input, AudioOutput* output);
+// Renders `frames` stereo frames (at most AUDIO_BLOCK_SIZE) into output
+typedef void (*AudioCallbackFn)(const AudioInput* input, AudioOutput* output, size_t frames);
 typedef void (*OnAudioStartCallbackFn)();
+// Applies a queued MIDI/CV/BPM event on the audio core
+typedef void (*AudioEventHandlerFn)(const AudioEvent& event);
 
 using AudioStopCallbackFn = std::function<void()>;
 using OnAudioStopCallbackFn = std::function<void()>;
 
-critical_section_t audioCS;
-critical_section_t adcCS;
-
 // Forward declaration of the singleton class for Core1
 class AudioManager;
 AudioManager* g_audio_manager_instance = nullptr;
@@ -45,10 +60,26 @@ private:
     AudioStopCallbackFn audioStopCallback = nullptr;
     OnAudioStopCallbackFn onAudioStopCallback = nullptr;
     OnAudioStartCallbackFn onAudioStartCallback = nullptr;
+    AudioEventHandlerFn audioEventHandler = nullptr;
     
     DAC dac;
+    AdcCapture* adcCapture = AdcCapture::getInstance();
+    AudioLoadMeter loadMeter;
+    SpscQueue<AudioEvent, AUDIO_EVENT_QUEUE_SIZE> events;
+    uint32_t droppedEvents = 0;
+
+    // Frame position of the block being rendered and when it started, so
+    // core0 can timestamp events in between blocks (see now()). Odd
+    // clockSequence means core1 is updating it.
+    volatile uint32_t clockSequence = 0;
+    uint32_t clockFrame = 0;
+    uint32_t clockTimeUs = 0;
+    uint32_t sampleRate = 44100;
+    // Aligned to their size for the DAC's DMA read ring
+    uint32_t dmaBufferA[AUDIO_BLOCK_SIZE] __attribute__((aligned(AUDIO_BLOCK_SIZE * sizeof(uint32_t))));
+    uint32_t dmaBufferB[AUDIO_BLOCK_SIZE] __attribute__((aligned(AUDIO_BLOCK_SIZE * sizeof(uint32_t))));
     bool initialized;
-    bool running = false;
+    volatile bool running = false;
     bool adcEnabled = false;
     
     // Private constructor for singleton pattern
@@ -61,60 +92,135 @@ private:
     AudioManager(const AudioManager&) = delete;
     AudioManager& operator=(const AudioManager&) = delete;
 
-    // Helper function called by Core1
-    static void core1_main() {
-        // Access the singleton instance
-        AudioManager* audio_mgr = AudioManager::getInstance();
+    static inline void packBlock(const AudioOutput* output, uint32_t* frames) {
+        for (size_t i = 0; i < AUDIO_BLOCK_SIZE; i++) {
+            int16_t left = std::clamp(output[i].left * 32768.0f, -32768.0f, 32767.0f);
+            int16_t right = std::clamp(output[i].right * 32768.0f, -32768.0f, 32767.0f);
+            frames[i] = DAC::packStereo(left, right);
+        }
+    }
 
-        adc_init();
-        adc_gpio_init(26 + A0);
-        adc_gpio_init(26 + A1);
+    void publishClock(uint32_t frame) {
+        clockSequence++;
+        __dmb();
+        clockFrame = frame;
+        clockTimeUs = time_us_32();
+        __dmb();
+        clockSequence++;
+    }
+
+    void dispatchEvent(const AudioEvent& event) {
+        if (event.type == AUDIO_EVENT_CALL) {
+            event.fn(event.context, event.arg);
+        } else if (audioEventHandler) {
+            audioEventHandler(event);
+        }
+    }
 
-        uint32_t delay_us = 1000000 / audio_mgr->dac.getSampleRate(); // Microseconds between samples
-        absolute_time_t next_sample_time = get_absolute_time();
+    // Renders one block, applying queued events on the frame they're due.
+    // The block is split at each event, so the callback may be asked for
+    // fewer than AUDIO_BLOCK_SIZE frames at a time.
+    __attribute__((hot)) void renderBlock(const AudioInput* input, AudioOutput* output) {
+        uint32_t blockFrame = clockFrame;
+        size_t offset = 0;
+
+        while (offset < AUDIO_BLOCK_SIZE) {
+            const AudioEvent* event;
+            size_t end = AUDIO_BLOCK_SIZE;
+
+            while ((event = events.peek()) != nullptr) {
+                int32_t due = (int32_t)(event->frame - blockFrame);
+                if (due > (int32_t)offset) {
+                    end = MIN(end, (size_t)due);
+                    break;
+                }
+                // Due now, or late (posted before the block started)
+                dispatchEvent(*event);
+                events.pop();
+            }
 
-        while (true) {
-            // Calculate next sample time
-            // next_sample_time = delayed_by_us(next_sample_time, delay_us);
+            audioCallback(input + offset, output + offset, end - offset);
+            offset = end;
+        }
 
-            AudioInput input;
+        publishClock(blockFrame + AUDIO_BLOCK_SIZE);
+    }
 
-            if (audio_mgr->adcEnabled) {
-                audio_mgr->startAdcLock();
-                adc_select_input(A0);
-                int16_t a0 = adc_read() - 2048;
-                float a0Norm = a0/2048.0f;
+    // Render straight into the DMA buffers. While a block renders,
+    // the previous one is already playing, so a slow block doesn't click
+    // as long as it fits within one block period.
+    void runDmaLoop() {
+        AudioInput input[AUDIO_BLOCK_SIZE] = {};
+        AudioOutput output[AUDIO_BLOCK_SIZE];
+
+        dac.startDma();
+        while (running) {
+            uint32_t* frames = dac.acquireBuffer();
+            uint32_t startCycles = loadMeter.begin();
+            if (adcEnabled) {
+                adcCapture->readAudio(input, AUDIO_BLOCK_SIZE);
+            }
+            renderBlock(input, output);
+            packBlock(output, frames);
+            loadMeter.end(startCycles);
+            dac.submitBuffer();
+        }
+        dac.stopDma();
+    }
 
-                adc_select_input(A1);
-                int16_t a1 = adc_read() - 2048;
-                float a1Norm = a1/2048.0f;
-                audio_mgr->endAdcLock();
+    // Blocking FIFO writes. The FIFO paces this loop at the sample rate.
+    void runBlockingLoop() {
+        AudioInput input[AUDIO_BLOCK_SIZE] = {};
+        AudioOutput output[AUDIO_BLOCK_SIZE];
+        uint32_t frames[AUDIO_BLOCK_SIZE];
 
-                input.left = a0Norm;
-                input.right = a1Norm;
+        while (running) {
+            uint32_t startCycles = loadMeter.begin();
+            if (adcEnabled) {
+                adcCapture->readAudio(input, AUDIO_BLOCK_SIZE);
             }
+            renderBlock(input, output);
+            packBlock(output, frames);
+            loadMeter.end(startCycles);
 
-            AudioOutput output;
-            audio_mgr->audioCallback(&input, &output);
-
-            int16_t left = std::clamp(output.left * 32768.0f, -32768.0f, 32767.0f);
-            int16_t right = std::clamp(output.right * 32768.0f, -32768.0f, 32767.0f);
-
-            audio_mgr->dac.writeMono(left, right);
-                                                  
-            if (!audio_mgr->running) {
-                if (audio_mgr->audioStopCallback) {
-                    audio_mgr->audioStopCallback();
-                    audio_mgr->audioStopCallback = nullptr;
-                    if (audio_mgr->onAudioStopCallback) {
-                        audio_mgr->onAudioStopCallback();
-                    }
-                }
-                break;
+            for (size_t i = 0; i < AUDIO_BLOCK_SIZE; i++) {
+                dac.writeStereo(frames[i]);
             }
+        }
+    }
+
+    // Runs on core0 while core1 is parked for a flash write
+    static void silenceOutput() {
+        getInstance()->dac.silenceDma();
+    }
+
+    // Helper function called by Core1
+    static void core1_main() {
+        // Access the singleton instance
+        AudioManager* audio_mgr = AudioManager::getInstance();
+
+        audio_mgr->loadMeter.init(audio_mgr->dac.getSampleRate(), AUDIO_BLOCK_SIZE);
+        audio_mgr->publishClock(0);
+
+        // Config saves and uploads write flash from core0 while this core
+        // runs from XIP flash and PSRAM: let them park it (see pico_lfs.h)
+        multicore_lockout_victim_init();
+        flash_lockout_core1 = true;
+
+        if (AUDIO_OUTPUT_DMA) {
+            audio_mgr->runDmaLoop();
+        } else {
+            audio_mgr->runBlockingLoop();
+        }
 
-            // Wait until it's time for the next sample
-            // sleep_until(next_sample_time);
+        flash_lockout_core1 = false;
+
+        if (audio_mgr->audioStopCallback) {
+            audio_mgr->audioStopCallback();
+            audio_mgr->audioStopCallback = nullptr;
+            if (audio_mgr->onAudioStopCallback) {
+                audio_mgr->onAudioStopCallback();
+            }
         }
     }
 
@@ -133,11 +239,15 @@ public:
             return;
         }
 
-        critical_section_init(&audioCS);
-        critical_section_init(&adcCS);
-        
         // Initialize DAC
         dac.init(sample_rate);
+        sampleRate = sample_rate;
+        dac.initDma(dmaBufferA, dmaBufferB, AUDIO_BLOCK_SIZE);
+        // While a flash write has core1 parked, DMA loops silence
+        flash_parked_callback = silenceOutput;
+
+        // Audio inputs and CVs stream in from here on (IO reads the CVs too)
+        adcCapture->init(sample_rate);
         
         initialized = true;
         start();
@@ -155,6 +265,11 @@ public:
         onAudioStopCallback = callback;
     }
 
+    void setAudioEventHandler(AudioEventHandlerFn handler) {
+        audioEventHandler = handler;
+    }
+
+    // Pass the A0/A1 audio inputs to the app (silence otherwise)
     void setAdcEnabled(bool enabled) {
         adcEnabled = enabled;
     }
@@ -162,26 +277,87 @@ public:
     bool isAdcEnabled() {
         return adcEnabled;
     }
+
+    size_t getBlockSize() const {
+        return AUDIO_BLOCK_SIZE;
+    }
     
+    // Render time of the audio blocks over the last ~1s window
+    AudioLoadStats getLoadStats() const {
+        return loadMeter.getStats();
+    }
+
+    // Blocks the DAC had to replay because the next one wasn't ready in time
+    uint32_t getUnderruns() const {
+        return dac.getUnderruns();
+    }
+
     // Get the DAC instance
     DAC* getDac() {
         return &dac;
     }
 
-    void startAudioLock() {
-        critical_section_enter_blocking(&audioCS);
+    // Current audio frame as seen from core0: the block being rendered plus
+    // the time since it started. Only meaningful while audio is running.
+    uint32_t now() const {
+        uint32_t sequence, frame, timeUs;
+        do {
+            sequence = clockSequence;
+            __dmb();
+            frame = clockFrame;
+            timeUs = clockTimeUs;
+            __dmb();
+        } while ((sequence & 1) || sequence != clockSequence);
+
+        uint32_t elapsed = (uint32_t)((uint64_t)(time_us_32() - timeUs) * sampleRate / 1000000);
+        return frame + MIN(elapsed, (uint32_t)AUDIO_BLOCK_SIZE - 1);
     }
 
-    void endAudioLock() {
-        critical_section_exit(&audioCS);
+    // Queue an event for the audio core (core0 only). It is applied one block
+    // after now(), so every event sees the same latency regardless of where
+    // in the block it arrived. Returns false if the queue was full.
+    bool postEvent(AudioEvent event) {
+        event.frame = now() + AUDIO_BLOCK_SIZE;
+        if (!events.push(event)) {
+            droppedEvents++;
+            return false;
+        }
+        return true;
     }
 
-    void startAdcLock() {
-        critical_section_enter_blocking(&adcCS);
+    bool postEvent(AudioEventType type, uint8_t channel, uint8_t data1, uint8_t data2) {
+        AudioEvent event = {};
+        event.type = type;
+        event.channel = channel;
+        event.data1 = data1;
+        event.data2 = data2;
+        return postEvent(event);
     }
-    
-    void endAdcLock() {
-        critical_section_exit(&adcCS);
+
+    bool postValue(AudioEventType type, uint16_t value) {
+        AudioEvent event = {};
+        event.type = type;
+        event.value = value;
+        return postEvent(event);
+    }
+
+    // Run fn(context, arg) on the audio core between two blocks
+    bool postCall(AudioEventFn fn, void* context, int32_t arg = 0) {
+        AudioEvent event = {};
+        event.type = AUDIO_EVENT_CALL;
+        event.fn = fn;
+        event.context = context;
+        event.arg = arg;
+        return postEvent(event);
+    }
+
+    uint32_t getDroppedEvents() const {
+        return droppedEvents;
+    }
+
+    // False once stop() has been called, until start()
+    bool isRunning() const {
+        return running;
     }
 
     void stop(AudioStopCallbackFn callback = nullptr) {
@@ -194,8 +370,16 @@ public:
             onAudioStartCallback();
         }
         running = true;
-        // Launch Core1 with our static helper function
+        // Launch Core1 with our static helper function. Until it's back
+        // up, flash writes have nothing to park.
+        flash_lockout_core1 = false;
         multicore_reset_core1();
+        // Core1 may have been reset before it stopped its DMA channels
+        dac.stopDma();
+        // Events posted while stopped carry stale timestamps; the clock
+        // restarts from frame 0
+        events.clear();
+        publishClock(0);
         multicore_launch_core1(core1_main);
     }
 };
\ No newline at end of file
@@ -2,11 +2,17 @@
 #include <math.h>
 #include <stdint.h>
 #include "audio/manager.h"
+#include "audio/mod/Modulation.h"
+#include "audio/mod/BiquadCascade.h"
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
 #endif
 
+// Changes to cutoff, Q or type glide to the new coefficients over one
+// control period (CONTROL_RATE_SAMPLES), so they don't click and can be
+// driven from a modulator. The coefficients come from the BiquadCache; for
+// other modes or several sections in series see BiquadCascade.
 class Biquad {
 public:
     enum FilterType {
@@ -17,11 +23,14 @@ public:
     Biquad(FilterType t)
         : sampleRate(48000.0f), cutoff(1000.0f), q(0.707f), type(t), z1(0.0f), z2(0.0f) {
         updateCoeffs();
+        snapCoeffs();
     }
 
     void init(AudioManager* audioManager) {
         sampleRate = audioManager->getDac()->getSampleRate();
+        BiquadCache::getInstance()->setSampleRate(sampleRate);
         updateCoeffs();
+        snapCoeffs();
     }
 
     void setCutoff(float freq) {
@@ -40,6 +49,9 @@ public:
     }
 
     float process(float input) {
+        if (rampRemaining > 0) {
+            stepCoeffs();
+        }
         float out = a0 * input + a1 * z1 + a2 * z2 - b1 * y1 - b2 * y2;
         z2 = z1;
         z1 = input;
@@ -48,6 +60,33 @@ public:
         return out;
     }
 
+    // In place, with the history kept in locals across the block
+    __attribute__((hot)) void processBlock(float* samples, size_t frames) {
+        if (rampRemaining > 0) {
+            // Coefficients move every sample: take the per-sample path
+            for (size_t n = 0; n < frames; n++) {
+                samples[n] = process(samples[n]);
+            }
+            return;
+        }
+
+        const float c0 = a0, c1 = a1, c2 = a2, d1 = b1, d2 = b2;
+        float x1 = z1, x2 = z2, o1 = y1, o2 = y2;
+        for (size_t n = 0; n < frames; n++) {
+            float input = samples[n];
+            float out = c0 * input + c1 * x1 + c2 * x2 - d1 * o1 - d2 * o2;
+            x2 = x1;
+            x1 = input;
+            o2 = o1;
+            o1 = out;
+            samples[n] = out;
+        }
+        z1 = x1;
+        z2 = x2;
+        y1 = o1;
+        y2 = o2;
+    }
+
     void reset() {
         z1 = z2 = y1 = y2 = 0.0f;
     }
@@ -57,29 +96,50 @@ private:
     float cutoff;
     float q;
     FilterType type;
-    float a0, a1, a2, b1, b2;
+    float a0 = 0.0f, a1 = 0.0f, a2 = 0.0f, b1 = 0.0f, b2 = 0.0f;
+    // Coefficients being ramped to, and the step per sample
+    float target[5];
+    float step[5];
+    uint16_t rampRemaining = 0;
     float z1, z2; // input history
     float y1 = 0.0f, y2 = 0.0f; // output history
 
+    // Works out the target coefficients and starts ramping to them
     void updateCoeffs() {
-        float omega = 2.0f * M_PI * cutoff / sampleRate;
-        float alpha = sinf(omega) / (2.0f * q);
-        float cosw = cosf(omega);
-        float norm;
-        if (type == LOWPASS) {
-            norm = 1.0f / (1.0f + alpha);
-            a0 = (1.0f - cosw) * 0.5f * norm;
-            a1 = (1.0f - cosw) * norm;
-            a2 = a0;
-            b1 = -2.0f * cosw * norm;
-            b2 = (1.0f - alpha) * norm;
-        } else if (type == HIGHPASS) {
-            norm = 1.0f / (1.0f + alpha);
-            a0 = (1.0f + cosw) * 0.5f * norm;
-            a1 = -(1.0f + cosw) * norm;
-            a2 = a0;
-            b1 = -2.0f * cosw * norm;
-            b2 = (1.0f - alpha) * norm;
+        const BiquadCoefficients& c = BiquadCache::getInstance()->get(
+            type == LOWPASS ? BIQUAD_LOWPASS : BIQUAD_HIGHPASS, cutoff, q);
+        target[0] = c.b0;
+        target[1] = c.b1;
+        target[2] = c.b2;
+        target[3] = c.a1;
+        target[4] = c.a2;
+
+        const float current[5] = {a0, a1, a2, b1, b2};
+        for (int i = 0; i < 5; i++) {
+            step[i] = (target[i] - current[i]) / CONTROL_RATE_SAMPLES;
+        }
+        rampRemaining = CONTROL_RATE_SAMPLES;
+    }
+
+    void snapCoeffs() {
+        a0 = target[0];
+        a1 = target[1];
+        a2 = target[2];
+        b1 = target[3];
+        b2 = target[4];
+        rampRemaining = 0;
+    }
+
+    void stepCoeffs() {
+        if (--rampRemaining == 0) {
+            // Land exactly on the target
+            snapCoeffs();
+            return;
         }
+        a0 += step[0];
+        a1 += step[1];
+        a2 += step[2];
+        b1 += step[3];
+        b2 += step[4];
     }
 }; 
\ No newline at end of file
@@ -0,0 +1,383 @@
+#pragma once
+#include <math.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <algorithm>
+#include "audio/manager.h"
+#include "audio/mod/Modulation.h"
+#include "audio/tools/fastmath.h"
+
+#define BIQUAD_CASCADE_MAX_SECTIONS 8
+
+// Direct-mapped, so a lookup is one hash and one compare
+#define BIQUAD_CACHE_BITS 8
+#define BIQUAD_CACHE_SIZE (1 << BIQUAD_CACHE_BITS)
+
+// Coefficients are designed (and cached) on a grid. Cutoff and Q are cut
+// straight from their float bits (exponent + top mantissa bits), so the
+// grid is roughly logarithmic without computing a log: 7 bits is 1/15 to
+// 1/8 semitone, 5 bits is 1.5-3% of Q. Gain goes in 0.25 dB steps. Well
+// below what can be heard, and the cascade glides between grid points.
+#define BIQUAD_CUTOFF_MANTISSA_BITS 7
+#define BIQUAD_Q_MANTISSA_BITS 5
+#define BIQUAD_GAIN_STEPS_PER_DB 4
+#define BIQUAD_MIN_CUTOFF 10.0f
+#define BIQUAD_MIN_Q 0.1f
+#define BIQUAD_MIN_GAIN_DB -48.0f
+
+enum BiquadMode : uint8_t {
+    BIQUAD_LOWPASS,
+    BIQUAD_HIGHPASS,
+    BIQUAD_BANDPASS,   // Constant 0 dB peak
+    BIQUAD_NOTCH,
+    BIQUAD_PEAK,       // Bell, gain in dB
+    BIQUAD_LOWSHELF,   // Gain in dB, Q sets the slope
+    BIQUAD_HIGHSHELF,
+};
+
+// Normalised by a0: y = b0 x + b1 x[-1] + b2 x[-2] - a1 y[-1] - a2 y[-2]
+typedef struct {
+    float b0, b1, b2, a1, a2;
+} BiquadCoefficients;
+
+class BiquadCache;
+BiquadCache* biquad_cache_instance = nullptr;
+
+// Audio core: the only core that fills or reads the cache table
+#define BIQUAD_CACHE_CORE 1
+
+// Coefficients for recently used (mode, cutoff, Q, gain) points, so knob
+// sweeps from CV or MIDI CC mostly skip the design maths. Shared by every
+// BiquadCascade and Biquad. The table belongs to the audio core: a filter
+// built or set up on core0 (e.g. an effect being hot-swapped in while audio
+// renders) gets the same grid point designed straight into a scratch copy,
+// without touching the table.
+class BiquadCache {
+    private:
+        typedef struct {
+            uint32_t key;   // 0 = empty
+            BiquadCoefficients coefficients;
+        } Entry;
+
+        Entry entries[BIQUAD_CACHE_SIZE] = {};
+        BiquadCoefficients scratch = {}; // Other cores' designs, see get()
+        float sampleRate = 44100.0f;
+        uint32_t hits = 0;
+        uint32_t misses = 0;
+
+        static uint32_t quantize(float value, float steps, uint32_t maxIndex) {
+            float index = value * steps + 0.5f;
+            return index <= 0.0f ? 0 : std::min((uint32_t)index, maxIndex);
+        }
+
+        // Grid step of a positive float, counted from `minimum`
+        static uint32_t logStep(float value, float minimum, int mantissaBits, uint32_t maxIndex) {
+            uint32_t bits, minimumBits;
+            value = std::max(value, minimum);
+            memcpy(&bits, &value, sizeof(bits));
+            memcpy(&minimumBits, &minimum, sizeof(minimumBits));
+            int shift = 23 - mantissaBits;
+            return std::min((bits >> shift) - (minimumBits >> shift), maxIndex);
+        }
+
+        // Middle of a logStep()
+        static float fromLogStep(uint32_t index, float minimum, int mantissaBits) {
+            uint32_t minimumBits;
+            memcpy(&minimumBits, &minimum, sizeof(minimumBits));
+            int shift = 23 - mantissaBits;
+            uint32_t bits = (((minimumBits >> shift) + index) << shift) | (1u << (shift - 1));
+            float value;
+            memcpy(&value, &bits, sizeof(value));
+            return value;
+        }
+
+    public:
+        static BiquadCache* getInstance() {
+            if (biquad_cache_instance == nullptr) {
+                biquad_cache_instance = new BiquadCache();
+            }
+            return biquad_cache_instance;
+        }
+
+        // Forgets everything if the rate changed (audio stopped)
+        void setSampleRate(float rate) {
+            if (rate != sampleRate) {
+                sampleRate = rate;
+                clear();
+            }
+        }
+
+        void clear() {
+            for (Entry& entry : entries) {
+                entry.key = 0;
+            }
+        }
+
+        // Cookbook (RBJ) designs
+        static void design(BiquadMode mode, float cutoff, float q, float gainDb, float sampleRate,
+                           BiquadCoefficients& out) {
+            float omega = 2.0f * (float)M_PI * std::min(cutoff, sampleRate * 0.49f) / sampleRate;
+            float sinw = fastSin(omega);
+            float cosw = fastCos(omega);
+            float alpha = sinw / (2.0f * q);
+            float a = dbToGain(gainDb * 0.5f);
+            float b0, b1, b2, a0, a1, a2;
+
+            switch (mode) {
+                case BIQUAD_LOWPASS:
+                    b1 = 1.0f - cosw;
+                    b0 = b2 = b1 * 0.5f;
+                    a0 = 1.0f + alpha; a1 = -2.0f * cosw; a2 = 1.0f - alpha;
+                    break;
+                case BIQUAD_HIGHPASS:
+                    b1 = -(1.0f + cosw);
+                    b0 = b2 = -b1 * 0.5f;
+                    a0 = 1.0f + alpha; a1 = -2.0f * cosw; a2 = 1.0f - alpha;
+                    break;
+                case BIQUAD_BANDPASS:
+                    b0 = alpha; b1 = 0.0f; b2 = -alpha;
+                    a0 = 1.0f + alpha; a1 = -2.0f * cosw; a2 = 1.0f - alpha;
+                    break;
+                case BIQUAD_NOTCH:
+                    b0 = 1.0f; b1 = -2.0f * cosw; b2 = 1.0f;
+                    a0 = 1.0f + alpha; a1 = -2.0f * cosw; a2 = 1.0f - alpha;
+                    break;
+                case BIQUAD_PEAK:
+                    b0 = 1.0f + alpha * a; b1 = -2.0f * cosw; b2 = 1.0f - alpha * a;
+                    a0 = 1.0f + alpha / a; a1 = -2.0f * cosw; a2 = 1.0f - alpha / a;
+                    break;
+                case BIQUAD_LOWSHELF:
+                case BIQUAD_HIGHSHELF:
+                default: {
+                    float sqrtA2alpha = 2.0f * sqrtf(a) * alpha;
+                    float sign = mode == BIQUAD_LOWSHELF ? 1.0f : -1.0f;
+                    b0 = a * ((a + 1.0f) - sign * (a - 1.0f) * cosw + sqrtA2alpha);
+                    b1 = sign * 2.0f * a * ((a - 1.0f) - sign * (a + 1.0f) * cosw);
+                    b2 = a * ((a + 1.0f) - sign * (a - 1.0f) * cosw - sqrtA2alpha);
+                    a0 = (a + 1.0f) + sign * (a - 1.0f) * cosw + sqrtA2alpha;
+                    a1 = -sign * 2.0f * ((a - 1.0f) + sign * (a + 1.0f) * cosw);
+                    a2 = (a + 1.0f) + sign * (a - 1.0f) * cosw - sqrtA2alpha;
+                    break;
+                }
+            }
+
+            float norm = 1.0f / a0;
+            out.b0 = b0 * norm;
+            out.b1 = b1 * norm;
+            out.b2 = b2 * norm;
+            out.a1 = a1 * norm;
+            out.a2 = a2 * norm;
+        }
+
+        // Coefficients for the grid point nearest to the request. Gain only
+        // matters for PEAK and the shelves. Off the audio core the result
+        // is only good until the next call there, so copy it right away.
+        const BiquadCoefficients& get(BiquadMode mode, float cutoff, float q, float gainDb = 0.0f) {
+            uint32_t cutoffIndex = logStep(cutoff, BIQUAD_MIN_CUTOFF, BIQUAD_CUTOFF_MANTISSA_BITS, 2047);
+            uint32_t qIndex = logStep(q, BIQUAD_MIN_Q, BIQUAD_Q_MANTISSA_BITS, 255);
+            uint32_t gainIndex = mode >= BIQUAD_PEAK
+                ? quantize(gainDb - BIQUAD_MIN_GAIN_DB, BIQUAD_GAIN_STEPS_PER_DB, 383)
+                : 0;
+
+            // 1 | mode:3 | gain:9 | q:8 | cutoff:11
+            uint32_t key = 0x80000000u | ((uint32_t)mode << 28) | (gainIndex << 19) | (qIndex << 11) | cutoffIndex;
+            float gridCutoff = fromLogStep(cutoffIndex, BIQUAD_MIN_CUTOFF, BIQUAD_CUTOFF_MANTISSA_BITS);
+            float gridQ = fromLogStep(qIndex, BIQUAD_MIN_Q, BIQUAD_Q_MANTISSA_BITS);
+            float gridGain = BIQUAD_MIN_GAIN_DB + (float)gainIndex / BIQUAD_GAIN_STEPS_PER_DB;
+            if (get_core_num() != BIQUAD_CACHE_CORE) {
+                design(mode, gridCutoff, gridQ, gridGain, sampleRate, scratch);
+                return scratch;
+            }
+
+            Entry& entry = entries[(key * 2654435761u) >> (32 - BIQUAD_CACHE_BITS)];
+            if (entry.key == key) {
+                hits++;
+                return entry.coefficients;
+            }
+
+            misses++;
+            design(mode, gridCutoff, gridQ, gridGain, sampleRate, entry.coefficients);
+            entry.key = key;
+            return entry.coefficients;
+        }
+
+        uint32_t getHits() const {
+            return hits;
+        }
+
+        uint32_t getMisses() const {
+            return misses;
+        }
+};
+
+// Up to BIQUAD_CASCADE_MAX_SECTIONS second-order sections in series, each
+// with its own mode, cutoff, Q and gain (transposed direct form II).
+// Parameter changes take their coefficients from the BiquadCache and glide
+// to them over one control period, like Biquad.
+class BiquadCascade {
+    private:
+        typedef struct {
+            BiquadMode mode;
+            float cutoff;
+            float q;
+            float gainDb;
+        } Section;
+
+        uint8_t sections;
+        Section params[BIQUAD_CASCADE_MAX_SECTIONS];
+        BiquadCoefficients coefficients[BIQUAD_CASCADE_MAX_SECTIONS];
+        BiquadCoefficients targets[BIQUAD_CASCADE_MAX_SECTIONS];
+        BiquadCoefficients steps[BIQUAD_CASCADE_MAX_SECTIONS];
+        float z1[BIQUAD_CASCADE_MAX_SECTIONS];
+        float z2[BIQUAD_CASCADE_MAX_SECTIONS];
+        uint16_t rampRemaining = 0;
+        bool initialized = false;
+        BiquadCache* cache = BiquadCache::getInstance();
+
+        // Picks up the section's new target and glides every section from
+        // where it is now to its target
+        void updateSection(uint8_t section) {
+            const Section& p = params[section];
+            targets[section] = cache->get(p.mode, p.cutoff, p.q, p.gainDb);
+            if (!initialized) {
+                coefficients[section] = targets[section];
+                return;
+            }
+
+            for (uint8_t s = 0; s < sections; s++) {
+                const BiquadCoefficients& to = targets[s];
+                const BiquadCoefficients& from = coefficients[s];
+                steps[s].b0 = (to.b0 - from.b0) / CONTROL_RATE_SAMPLES;
+                steps[s].b1 = (to.b1 - from.b1) / CONTROL_RATE_SAMPLES;
+                steps[s].b2 = (to.b2 - from.b2) / CONTROL_RATE_SAMPLES;
+                steps[s].a1 = (to.a1 - from.a1) / CONTROL_RATE_SAMPLES;
+                steps[s].a2 = (to.a2 - from.a2) / CONTROL_RATE_SAMPLES;
+            }
+            rampRemaining = CONTROL_RATE_SAMPLES;
+        }
+
+        inline void stepCoefficients() {
+            if (--rampRemaining == 0) {
+                // Land exactly on the targets
+                for (uint8_t s = 0; s < sections; s++) {
+                    coefficients[s] = targets[s];
+                }
+                return;
+            }
+            for (uint8_t s = 0; s < sections; s++) {
+                coefficients[s].b0 += steps[s].b0;
+                coefficients[s].b1 += steps[s].b1;
+                coefficients[s].b2 += steps[s].b2;
+                coefficients[s].a1 += steps[s].a1;
+                coefficients[s].a2 += steps[s].a2;
+            }
+        }
+
+    public:
+        explicit BiquadCascade(uint8_t sections = 2)
+            : sections(std::clamp(sections, (uint8_t)1, (uint8_t)BIQUAD_CASCADE_MAX_SECTIONS)) {
+            for (uint8_t s = 0; s < BIQUAD_CASCADE_MAX_SECTIONS; s++) {
+                params[s] = {BIQUAD_LOWPASS, 1000.0f, 0.707f, 0.0f};
+            }
+            reset();
+        }
+
+        void init(AudioManager* audioManager) {
+            cache->setSampleRate(audioManager->getDac()->getSampleRate());
+            initialized = false;
+            for (uint8_t s = 0; s < sections; s++) {
+                updateSection(s);
+            }
+            rampRemaining = 0;
+            initialized = true;
+        }
+
+        uint8_t getSections() const {
+            return sections;
+        }
+
+        void setSection(uint8_t section, BiquadMode mode, float cutoff, float q, float gainDb = 0.0f) {
+            if (section >= sections) {
+                return;
+            }
+            params[section] = {mode, cutoff, q, gainDb};
+            updateSection(section);
+        }
+
+        void setMode(uint8_t section, BiquadMode mode) {
+            if (section < sections) {
+                params[section].mode = mode;
+                updateSection(section);
+            }
+        }
+
+        void setCutoff(uint8_t section, float cutoff) {
+            if (section < sections) {
+                params[section].cutoff = cutoff;
+                updateSection(section);
+            }
+        }
+
+        void setQ(uint8_t section, float q) {
+            if (section < sections) {
+                params[section].q = q;
+                updateSection(section);
+            }
+        }
+
+        void setGain(uint8_t section, float gainDb) {
+            if (section < sections) {
+                params[section].gainDb = gainDb;
+                updateSection(section);
+            }
+        }
+
+        inline float process(float input) {
+            if (rampRemaining > 0) {
+                stepCoefficients();
+            }
+
+            float x = input;
+            for (uint8_t s = 0; s < sections; s++) {
+                const BiquadCoefficients& c = coefficients[s];
+                float y = c.b0 * x + z1[s];
+                z1[s] = c.b1 * x - c.a1 * y + z2[s];
+                z2[s] = c.b2 * x - c.a2 * y;
+                x = y;
+            }
+            return x;
+        }
+
+        // In place, section by section
+        __attribute__((hot)) void processBlock(float* samples, size_t frames) {
+            if (rampRemaining > 0) {
+                // Coefficients move every sample: take the per-sample path
+                for (size_t n = 0; n < frames; n++) {
+                    samples[n] = process(samples[n]);
+                }
+                return;
+            }
+
+            for (uint8_t s = 0; s < sections; s++) {
+                const BiquadCoefficients c = coefficients[s];
+                float s1 = z1[s], s2 = z2[s];
+                for (size_t n = 0; n < frames; n++) {
+                    float x = samples[n];
+                    float y = c.b0 * x + s1;
+                    s1 = c.b1 * x - c.a1 * y + s2;
+                    s2 = c.b2 * x - c.a2 * y;
+                    samples[n] = y;
+                }
+                z1[s] = s1;
+                z2[s] = s2;
+            }
+        }
+
+        void reset() {
+            for (uint8_t s = 0; s < BIQUAD_CASCADE_MAX_SECTIONS; s++) {
+                z1[s] = 0.0f;
+                z2[s] = 0.0f;
+            }
+        }
+};
@@ -1,35 +1,80 @@
 #pragma once
 #include <stdint.h>
 #include <stddef.h>
+#include <algorithm>
 #include "audio/manager.h"
-#include "audio/mod/biquad.h"
-#include "psram.h"
+#include "audio/mod/BiquadCascade.h"
+#include "audio/tools/audio_memory.h"
+
+// How the delay line reads between two samples when the (smoothed) delay
+// time isn't a whole number of samples
+enum DelayInterpolation {
+    DELAY_INTERP_NONE,    // Nearest sample; cheapest, but steps on time changes
+    DELAY_INTERP_LINEAR,  // 2 taps; dulls the top end a little at half-sample delays
+    DELAY_INTERP_HERMITE, // 4-tap cubic; flat much further up, a few more multiplies
+    DELAY_INTERP_ALLPASS, // 2 taps and flat magnitude, for fixed or slow-moving delays
+};
+
+// What the delay line stores. The 16-bit modes take half the space of float,
+// and for lines in PSRAM half the QSPI traffic. They cover DELAY_INT16_HEADROOM times
+// full scale (12dB) so feedback can build up past 0dBFS before the stored
+// value saturates; the rounding noise still sits around -90dBFS.
+enum DelayStorage {
+    DELAY_STORAGE_FLOAT,
+    DELAY_STORAGE_INT16,        // Rounded
+    DELAY_STORAGE_INT16_DITHER, // TPDF dither, so long decays fade into noise instead of buzzing
+};
+
+#ifndef DELAY_INT16_HEADROOM
+#define DELAY_INT16_HEADROOM 4.0f
+#endif
 
 // Feedback Delay Effect
-// Efficient for MCUs, uses int16_t buffer for audio data
+// The buffer is rounded up to a power of two so the ring indexes wrap with a
+// mask instead of a modulo, and the delay time is read fractionally so tempo
+// and time changes glide instead of stepping. Short lines are placed in the
+// on-chip SRAM arena and long ones in PSRAM (see AudioMemory); longer delays,
+// or many lines at once, fit better with one of the 16-bit DelayStorage modes.
 class Delay {
 public:
     // maxDelayMs: maximum delay buffer size (in milliseconds)
-    Delay(float maxDelayMs)
-        : buffer(nullptr), maxDelay(0), maxDelayMs(maxDelayMs), targetDelaySamples(1000.0f), feedback(0.0f), wet(0.0f), writeIndex(0), sampleRate(44100), currentDelaySamples(1000.0f) {
+    // storage: sample format of the buffer
+    Delay(float maxDelayMs, DelayStorage storage = DELAY_STORAGE_FLOAT)
+        : buffer(nullptr), maxDelay(0), maxDelayMs(maxDelayMs), targetDelaySamples(1000.0f), feedback(0.0f), wet(0.0f), writeIndex(0), sampleRate(44100), currentDelaySamples(1000.0f), storage(storage) {
         // Buffer allocation is deferred to init()
     }
 
     ~Delay() {
+        releaseBuffer();
     }
 
+    // Owns its buffer
+    Delay(const Delay&) = delete;
+    Delay& operator=(const Delay&) = delete;
+
     // Initialize with AudioManager to get sample rate and allocate buffer
     void init(AudioManager* audioManager) {
         sampleRate = audioManager->getDac()->getSampleRate();
         maxDelay = (size_t)((maxDelayMs * sampleRate) / 1000.0f);
         if (maxDelay < 1) maxDelay = 1;
 
-        buffer = (float*)psram->alloc(maxDelay * sizeof(float));
+        // Room for the interpolator's extra taps past the longest delay
+        bufferSize = 1;
+        while (bufferSize < maxDelay + 2) bufferSize <<= 1;
+        mask = bufferSize - 1;
+
+        // Init again (the app restarting) reallocates rather than leaks
+        releaseBuffer();
+        if (storage == DELAY_STORAGE_FLOAT) {
+            buffer = (float*)memory->alloc(bufferSize * sizeof(float), MEMORY_HOT, PSRAM_ARENA_FX);
+        } else {
+            buffer16 = (int16_t*)memory->alloc(bufferSize * sizeof(int16_t), MEMORY_HOT, PSRAM_ARENA_FX);
+        }
         reset();
-        targetDelaySamples = 1000.0f;
+        targetDelaySamples = MIN(1000.0f, (float)maxDelay);
         currentDelaySamples = targetDelaySamples;
+        feedbackFilter.setCutoff(0, filterCutoff);
         feedbackFilter.init(audioManager);
-        feedbackFilter.setCutoff(filterCutoff);
     }
 
     // Set delay in beats (fractional allowed, e.g., 0.5 = eighth note)
@@ -37,10 +82,10 @@ public:
         delayBeats = beats;
         if (bpm > 0 && delayBeats > 0.0f) {
             float seconds = (60.0f * delayBeats) / bpm;
-            size_t samples = MIN((size_t)(seconds * sampleRate), maxDelay);
-            if (samples < 1) samples = 1;
+            float samples = MIN(seconds * sampleRate, (float)maxDelay);
+            if (samples < 1.0f) samples = 1.0f;
             // Update target immediately - smoothing happens in process()
-            targetDelaySamples = (float)samples;
+            targetDelaySamples = samples;
         }
     }
 
@@ -65,16 +110,28 @@ public:
         }
     }
 
+    // Choose how fractional delay times are read (default linear)
+    void setInterpolation(DelayInterpolation mode) {
+        interpolation = mode;
+        allpassState = 0.0f;
+    }
+
     // Reset buffer
     void reset() {
-        for (size_t i = 0; i < maxDelay; ++i) buffer[i] = 0;
+        if (buffer != nullptr) {
+            for (size_t i = 0; i < bufferSize; ++i) buffer[i] = 0;
+        }
+        if (buffer16 != nullptr) {
+            for (size_t i = 0; i < bufferSize; ++i) buffer16[i] = 0;
+        }
         writeIndex = 0;
+        allpassState = 0.0f;
         currentDelaySamples = targetDelaySamples;
     }
 
     // Process a single sample
     float process(float input) {
-        if (buffer == nullptr) return input;
+        if (buffer == nullptr && buffer16 == nullptr) return input;
 
         // Parameter smoothing for delay time
         const float smoothing = 0.005f; // 0.0 = no smoothing, 1.0 = instant
@@ -85,15 +142,14 @@ public:
             wet = pendingWet;
             pendingWetUpdate = false;
         }
-        size_t readIndex = (writeIndex + maxDelay - (size_t)currentDelaySamples) % maxDelay;
-        float delayed = buffer[readIndex];
+        float delayed = read(currentDelaySamples);
         
         // Apply feedback filter to delayed sample before feedback
         float filteredDelayed = feedbackFilter.process(delayed);
         float fbSample = input + filteredDelayed * feedback;
         
-        buffer[writeIndex] = fbSample;
-        writeIndex = (writeIndex + 1) % maxDelay;
+        write(fbSample);
+        writeIndex = (writeIndex + 1) & mask;
 
         // If delay is 0, return input
         if (currentDelaySamples < 1.0f) {
@@ -105,20 +161,54 @@ public:
         return out;
     }
 
+    // In place; the same as process() on each sample, with the smoothed
+    // delay time and mix kept in locals across the block
+    __attribute__((hot)) void processBlock(float* samples, size_t frames) {
+        if (buffer == nullptr && buffer16 == nullptr) return;
+
+        const float smoothing = 0.005f;
+        const float target = targetDelaySamples;
+        const float fb = feedback;
+        float delaySamples = currentDelaySamples;
+        float mix = currentWet;
+        float wetTarget = wet;
+
+        for (size_t n = 0; n < frames; n++) {
+            float input = samples[n];
+            delaySamples += smoothing * (target - delaySamples);
+            mix += smoothing * (wetTarget - mix);
+            if (pendingWetUpdate && fabs(mix - wetTarget) < 0.01f) {
+                wetTarget = wet = pendingWet;
+                pendingWetUpdate = false;
+            }
+
+            float filteredDelayed = feedbackFilter.process(read(delaySamples));
+            write(input + filteredDelayed * fb);
+            writeIndex = (writeIndex + 1) & mask;
+
+            if (delaySamples >= 1.0f) {
+                samples[n] = input * MAX(0.9f, 1.0f - mix) + filteredDelayed * mix;
+            }
+        }
+
+        currentDelaySamples = delaySamples;
+        currentWet = mix;
+    }
+
     // Set the feedback filter cutoff frequency (Hz)
     void setLowpassCutoff(float freq) {
         filterCutoff = freq;
-        feedbackFilter.setCutoff(freq);
+        feedbackFilter.setCutoff(0, freq);
     }
 
-    // Set the feedback filter type (LOWPASS or HIGHPASS)
-    void setFilterType(Biquad::FilterType type) {
-        feedbackFilter.setType(type);
+    // Set the feedback filter type (any BiquadMode)
+    void setFilterType(BiquadMode mode) {
+        feedbackFilter.setMode(0, mode);
     }
 
     // Set the feedback filter resonance (Q factor)
     void setResonance(float q) {
-        feedbackFilter.setResonance(q);
+        feedbackFilter.setQ(0, q);
     }
 
     // Set BPM and update delay if using beat-based delay
@@ -131,7 +221,10 @@ public:
 
 private:
     float* buffer;
-    size_t maxDelay;
+    int16_t* buffer16 = nullptr;
+    size_t maxDelay;   // Longest delay, in samples
+    size_t bufferSize = 0; // maxDelay rounded up to a power of two
+    size_t mask = 0;
     float maxDelayMs;
     float targetDelaySamples = 1000.0f; // Target delay time (smoothed in process())
     float feedback;
@@ -142,9 +235,96 @@ private:
     float currentWet = 0.0f;
     float pendingWet = 0.0f;
     bool pendingWetUpdate = false;
-    Biquad feedbackFilter = Biquad(Biquad::FilterType::LOWPASS);
+    BiquadCascade feedbackFilter{1};
     float filterCutoff = 20000.0f;
     uint16_t bpm = 0;
     float delayBeats = 0.0f;
-    PSRAM *psram = PSRAM::getInstance();
+    DelayInterpolation interpolation = DELAY_INTERP_LINEAR;
+    float allpassState = 0.0f;
+    DelayStorage storage;
+    uint32_t ditherState = 0x9e3779b9;
+    AudioMemory *memory = AudioMemory::getInstance();
+
+    void releaseBuffer() {
+        memory->free(buffer);
+        memory->free(buffer16);
+        buffer = nullptr;
+        buffer16 = nullptr;
+    }
+
+    // The sample written `samplesAgo` samples ago (1 = the last one)
+    inline float tap(size_t samplesAgo) const {
+        size_t index = (writeIndex - samplesAgo) & mask;
+        if (storage == DELAY_STORAGE_FLOAT) {
+            return buffer[index];
+        }
+        return buffer16[index] * (DELAY_INT16_HEADROOM / 32767.0f);
+    }
+
+    // Store the next sample at the write position
+    inline void write(float sample) {
+        if (storage == DELAY_STORAGE_FLOAT) {
+            buffer[writeIndex] = sample;
+            return;
+        }
+
+        float scaled = sample * (32767.0f / DELAY_INT16_HEADROOM);
+        if (storage == DELAY_STORAGE_INT16_DITHER) {
+            // Two uniform values from one xorshift step, minus each other:
+            // triangular, +-1 LSB
+            ditherState ^= ditherState << 13;
+            ditherState ^= ditherState >> 17;
+            ditherState ^= ditherState << 5;
+            scaled += ((int32_t)(ditherState >> 16) - (int32_t)(ditherState & 0xffff)) * (1.0f / 65536.0f);
+        }
+        scaled = std::clamp(scaled, -32767.0f, 32767.0f);
+        buffer16[writeIndex] = (int16_t)(scaled + (scaled < 0.0f ? -0.5f : 0.5f));
+    }
+
+    // Read `delaySamples` back, between samples per the interpolation mode
+    inline float read(float delaySamples) {
+        size_t whole = (size_t)delaySamples;
+        float frac = delaySamples - (float)whole;
+
+        switch (interpolation) {
+            case DELAY_INTERP_NONE:
+                return tap(whole);
+
+            case DELAY_INTERP_LINEAR: {
+                float x0 = tap(whole);
+                return x0 + frac * (tap(whole + 1) - x0);
+            }
+
+            case DELAY_INTERP_HERMITE: {
+                // Also reads the next newer sample, which isn't written
+                // yet at a one-sample delay
+                if (whole < 2) {
+                    whole = 2;
+                    frac = 0.0f;
+                }
+                float xm1 = tap(whole - 1);
+                float x0 = tap(whole);
+                float x1 = tap(whole + 1);
+                float x2 = tap(whole + 2);
+                float c1 = 0.5f * (x1 - xm1);
+                float c2 = xm1 - 2.5f * x0 + 2.0f * x1 - 0.5f * x2;
+                float c3 = 0.5f * (x2 - xm1) + 1.5f * (x0 - x1);
+                return ((c3 * frac + c2) * frac + c1) * frac + x0;
+            }
+
+            case DELAY_INTERP_ALLPASS: {
+                // Keep the fractional part in [0.5, 1.5) so the coefficient
+                // stays well away from the pole at -1 and doesn't jump from
+                // 0 to 1 as the delay crosses a whole sample
+                if (frac < 0.5f && whole > 1) {
+                    whole--;
+                    frac += 1.0f;
+                }
+                float eta = (1.0f - frac) / (1.0f + frac);
+                allpassState = eta * (tap(whole) - allpassState) + tap(whole + 1);
+                return allpassState;
+            }
+        }
+        return tap(whole);
+    }
 }; 
\ No newline at end of file
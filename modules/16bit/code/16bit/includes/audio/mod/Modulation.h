@@ -0,0 +1,136 @@
+#pragma once
+#include <math.h>
+#include <stdint.h>
+#include <algorithm>
+#include "audio/manager.h"
+#include "audio/tools/fastmath.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Control-rate modulation. Modulators (like the GateEnvelope) are evaluated
+// once every CONTROL_RATE_SAMPLES samples, and whatever they drive ramps
+// linearly to the new value in between, so expf()/coefficient updates
+// happen at control rate instead of on every sample.
+#ifndef CONTROL_RATE_SAMPLES
+#define CONTROL_RATE_SAMPLES 16
+#endif
+
+// Counts samples and says when a control tick is due
+class ControlClock {
+private:
+    uint16_t remaining = 1;
+
+public:
+    // Call once per sample; true on the first sample of each control period
+    inline bool tick() {
+        if (--remaining == 0) {
+            remaining = CONTROL_RATE_SAMPLES;
+            return true;
+        }
+        return false;
+    }
+
+    // Tick on the next sample
+    void reset() {
+        remaining = 1;
+    }
+};
+
+// A parameter that slides to its target over one control period
+class ParamRamp {
+private:
+    float value = 0.0f;
+    float step = 0.0f;
+    uint16_t remaining = 0;
+
+public:
+    // Jump straight to `target`
+    void set(float target) {
+        value = target;
+        remaining = 0;
+    }
+
+    void setTarget(float target) {
+        step = (target - value) / CONTROL_RATE_SAMPLES;
+        remaining = CONTROL_RATE_SAMPLES;
+    }
+
+    inline float next() {
+        if (remaining > 0) {
+            value += step;
+            remaining--;
+        }
+        return value;
+    }
+
+    float get() const {
+        return value;
+    }
+};
+
+class Modulator {
+protected:
+    float value = 0.0f;
+    float controlRate = 44100.0f / CONTROL_RATE_SAMPLES;
+
+public:
+    virtual ~Modulator() = default;
+
+    virtual void init(AudioManager* audioManager) {
+        controlRate = audioManager->getDac()->getSampleRate() / (float)CONTROL_RATE_SAMPLES;
+    }
+
+    // Advance one control period and return the new value
+    virtual float tick() = 0;
+
+    float getValue() const {
+        return value;
+    }
+};
+
+// One-pole attack/release towards 1 while the gate is on and 0 when it's
+// off. The rates are worked out when the times change, not per tick.
+class GateEnvelope : public Modulator {
+private:
+    float attackTime = 0.01f;  // seconds
+    float releaseTime = 0.1f;
+    float attackRate = 1.0f;
+    float releaseRate = 1.0f;
+    float target = 0.0f;
+
+    float rateFor(float seconds) const {
+        return 1.0f - fastExp(-1.0f / (seconds * controlRate + 1e-6f));
+    }
+
+    void updateRates() {
+        attackRate = rateFor(attackTime);
+        releaseRate = rateFor(releaseTime);
+    }
+
+public:
+    void init(AudioManager* audioManager) override {
+        Modulator::init(audioManager);
+        updateRates();
+    }
+
+    void setAttack(float seconds) {
+        attackTime = seconds;
+        updateRates();
+    }
+
+    void setRelease(float seconds) {
+        releaseTime = seconds;
+        updateRates();
+    }
+
+    void setGate(bool gate) {
+        target = gate ? 1.0f : 0.0f;
+    }
+
+    float tick() override {
+        value += (target - value) * (target > value ? attackRate : releaseRate);
+        return value;
+    }
+};
@@ -2,6 +2,7 @@
 #include <math.h>
 #include <stdint.h>
 #include "audio/manager.h"
+#include "audio/tools/fastmath.h"
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
@@ -75,10 +76,15 @@ private:
     float ic1eq, ic2eq;
 
     void updateCoeffs() {
-        // Clamp cutoff to Nyquist
-        float fc = fminf(fmaxf(cutoff, 10.0f), sampleRate * 0.45f);
-        float g = tanf(M_PI * fc / sampleRate);
         float k = 2.0f - 2.0f * resonance; // resonance: 0.0 (max Q) to 1.0 (no resonance)
+        coefficients(cutoff, k, sampleRate, a1, a2);
+    }
+
+public:
+    // a1/a2 for a cutoff (clamped below Nyquist) and damping k = 1/Q
+    static void coefficients(float cutoff, float k, float sampleRate, float& a1, float& a2) {
+        float fc = fminf(fmaxf(cutoff, 10.0f), sampleRate * 0.45f);
+        float g = fastTan((float)M_PI * fc / sampleRate);
         a1 = 1.0f / (1.0f + g * (g + k));
         a2 = g * a1;
     }
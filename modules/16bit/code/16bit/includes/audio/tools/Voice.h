@@ -1,120 +1,58 @@
 #pragma once
 #include "midi.h"
-#include "audio/manager.h"
-#include "audio/gen/AudioGenerator.h"
-#include "audio/env/Envelope.h"
-
+#include "audio/tools/VoiceEngine.h"
+
+// Handle on one voice of a VoiceEngine. The state lives in the engine's
+// arrays and is rendered there a block at a time; this only forwards the
+// note calls for the voice it points at.
+//
+// Each voice runs one oscillator, so a note is just the MIDI note (there are
+// no per-generator notes). The waveform and the amp/filter envelope times
+// are shared by all voices and set on the engine (setWaveform(),
+// setAttackTime(), ...), and finished voices come from
+// VoiceEngine::takeFinished() rather than a per-voice callback.
 class Voice {
     private:
-        AudioGenerator** generators;
-        uint8_t totalGenerators;
-        Envelope* ampEnvelope;
-        Envelope* filterEnvelope;
-        uint8_t currentNote;
+        VoiceEngine* engine;
         uint8_t voiceId;
-        static uint8_t voiceIdCounter;
-        std::function<void(Voice*)> onCompleteCallback = nullptr;
-        float velocity = 1.0f;
 
-        float waveform = 0;
-        
     public:
-        Voice(uint8_t totalGenerators, AudioGenerator* generators[], Envelope* ampEnvelope, Envelope* filterEnvelope)
-            : totalGenerators(totalGenerators), ampEnvelope(ampEnvelope), filterEnvelope(filterEnvelope) {
-                this->generators = new AudioGenerator*[totalGenerators];
-                for (uint8_t i = 0; i < totalGenerators; ++i) {
-                    this->generators[i] = generators[i];
-                }
-                voiceId = voiceIdCounter++;
-            }
-
-        ~Voice() {
-            delete[] generators;
-        }
-
-        void init(AudioManager* audioManager) {
-            currentNote = 48;
-            uint16_t freq = MIDI::midiNoteToFrequency(currentNote);
-
-            for (uint8_t i = 0; i < totalGenerators; ++i) {
-                generators[i]->init(audioManager);
-                generators[i]->setFrequency(freq);
-            }
-            ampEnvelope->init(audioManager);
-            ampEnvelope->setOnCompleteCallback([this]() { this->onEnvelopeComplete(); });
-        }
-
+        Voice(VoiceEngine* engine, uint8_t voiceId) : engine(engine), voiceId(voiceId) {}
 
-        void changeGenerators(AudioGenerator* generators[]) {
-            uint16_t freq = MIDI::midiNoteToFrequency(currentNote);
-            for (uint8_t i = 0; i < totalGenerators; ++i) {
-                this->generators[i] = generators[i];
-                this->generators[i]->setFrequency(freq);
-            }
+        // Pitch bend as a frequency ratio (see MIDI::semitonesToRatio),
+        // applied to the note already playing and to the next ones
+        void setPitchRatio(float ratio) {
+            engine->setPitchRatio(voiceId, ratio);
         }
 
-        void setOnCompleteCallback(std::function<void(Voice*)> callback) {
-            this->onCompleteCallback = callback;
+        void setNoteOn(float velocity, uint8_t note) {
+            engine->noteOn(voiceId, note, velocity);
         }
 
-        void setNoteOn(float velocity, uint8_t note, uint8_t* generatorNotes = nullptr) {
-            this->velocity = velocity;
-            currentNote = note;
-            for (uint8_t i = 0; i < totalGenerators; ++i) {
-                uint16_t freq;
-                if (generatorNotes) {
-                    freq = MIDI::midiNoteToFrequency(generatorNotes[i]);
-                } else {
-                    freq = MIDI::midiNoteToFrequency(note);
-                }
-                generators[i]->setFrequency(freq);
-            }
-            ampEnvelope->setTrigger(true);
-            filterEnvelope->setTrigger(true);
+        // Take the voice over for another note: fade out whatever it plays
+        // now, then start `note`. Starts right away if the voice is silent.
+        void steal(float velocity, uint8_t note) {
+            engine->steal(voiceId, note, velocity);
         }
 
         void setNoteOff(uint8_t note) {
-            if (note == currentNote) {
-                ampEnvelope->setTrigger(false);
-                filterEnvelope->setTrigger(false);
-            }
+            engine->noteOff(voiceId, note);
         }
 
-        float process() {
-            float sum = 0;
-            for (uint8_t i = 0; i < totalGenerators; ++i) {
-                sum += generators[i]->getSample();
-            }
-             
-            waveform = sum / totalGenerators;
-            return ampEnvelope->process(waveform) * velocity;
+        // Current output level (envelope times velocity)
+        float getLevel() const {
+            return engine->getLevel(voiceId);
         }
 
-        int16_t getWaveformOnly() {
-            return waveform;
-        }
-
-        Envelope* getAmpEnvelope() {
-            return ampEnvelope;
-        }
-
-        Envelope* getFilterEnvelope() {
-            return filterEnvelope;
+        bool isActive() const {
+            return engine->isActive(voiceId);
         }
 
         uint8_t getCurrentNote() {
-            return currentNote;
+            return engine->getNote(voiceId);
         }
 
         uint8_t getVoiceId() {
             return voiceId;
         }
-
-        void onEnvelopeComplete() {
-            if (onCompleteCallback) {
-                onCompleteCallback(this);
-            }
-        }
 };
-
-uint8_t Voice::voiceIdCounter = 0;
\ No newline at end of file
@@ -0,0 +1,189 @@
+#pragma once
+
+#include <stdint.h>
+
+#define VOICE_ALLOCATOR_MAX_VOICES 32
+#define VOICE_NONE -1
+
+// Which voice gives way when a note arrives and every voice is busy.
+// Released voices (fading out after note off) always go before held ones.
+enum VoiceStealMode : uint8_t {
+    VOICE_STEAL_OLDEST = 0,   // The note that started first
+    VOICE_STEAL_QUIETEST = 1, // The lowest envelope level right now
+    // A repeated note takes over the voice already playing it (otherwise
+    // oldest), so repeats never stack up and eat the polyphony
+    VOICE_STEAL_RETRIGGER = 2,
+    VOICE_STEAL_MODE_COUNT,
+};
+
+typedef struct {
+    int8_t voice;   // VOICE_NONE if there are no voices
+    bool stolen;    // The voice is still playing another note: fade it first
+} VoiceAssignment;
+
+// Maps notes to voices. Note on takes a voice off a free list, note off
+// finds the voice through a per-note list, both O(1); only stealing scans
+// the voices. Held voices are kept per note so the same note played twice
+// (without retrigger) is released by a single note off, as before.
+// Runs on the audio core, next to the voices.
+class VoiceAllocator {
+private:
+    enum VoiceState : uint8_t {
+        VOICE_FREE,
+        VOICE_HELD,
+        VOICE_RELEASED,
+    };
+
+    uint8_t totalVoices = 0;
+    VoiceStealMode stealMode = VOICE_STEAL_RETRIGGER;
+
+    VoiceState state[VOICE_ALLOCATOR_MAX_VOICES];
+    uint8_t voiceNote[VOICE_ALLOCATOR_MAX_VOICES];
+    uint32_t startedAt[VOICE_ALLOCATOR_MAX_VOICES];
+    uint32_t serial = 0;
+
+    int8_t freeList[VOICE_ALLOCATOR_MAX_VOICES];
+    uint8_t freeCount = 0;
+
+    // Held voices of each note, as doubly linked lists
+    int8_t heldHead[128];
+    int8_t nextHeld[VOICE_ALLOCATOR_MAX_VOICES];
+    int8_t prevHeld[VOICE_ALLOCATOR_MAX_VOICES];
+    // Voice that last started each note, held or not
+    int8_t lastVoice[128];
+
+    void linkHeld(int8_t voice, uint8_t note) {
+        prevHeld[voice] = VOICE_NONE;
+        nextHeld[voice] = heldHead[note];
+        if (heldHead[note] != VOICE_NONE) {
+            prevHeld[heldHead[note]] = voice;
+        }
+        heldHead[note] = voice;
+    }
+
+    void unlinkHeld(int8_t voice) {
+        uint8_t note = voiceNote[voice];
+        if (prevHeld[voice] != VOICE_NONE) {
+            nextHeld[prevHeld[voice]] = nextHeld[voice];
+        } else {
+            heldHead[note] = nextHeld[voice];
+        }
+        if (nextHeld[voice] != VOICE_NONE) {
+            prevHeld[nextHeld[voice]] = prevHeld[voice];
+        }
+    }
+
+    template <typename LevelFn>
+    int8_t pickVictim(LevelFn levelOf) {
+        int8_t victim = VOICE_NONE;
+        bool victimReleased = false;
+        float victimScore = 0.0f;
+
+        for (uint8_t voice = 0; voice < totalVoices; voice++) {
+            bool released = state[voice] == VOICE_RELEASED;
+            // Quietest: lowest level. Oldest: highest age.
+            float score = stealMode == VOICE_STEAL_QUIETEST
+                ? levelOf(voice)
+                : -(float)(uint32_t)(serial - startedAt[voice]);
+
+            if (victim == VOICE_NONE || (released && !victimReleased) ||
+                (released == victimReleased && score < victimScore)) {
+                victim = voice;
+                victimReleased = released;
+                victimScore = score;
+            }
+        }
+        return victim;
+    }
+
+public:
+    void init(uint8_t voices) {
+        totalVoices = voices < VOICE_ALLOCATOR_MAX_VOICES ? voices : VOICE_ALLOCATOR_MAX_VOICES;
+        for (int note = 0; note < 128; note++) {
+            heldHead[note] = VOICE_NONE;
+            lastVoice[note] = VOICE_NONE;
+        }
+
+        // Hand voices out from 0 up
+        freeCount = 0;
+        for (int8_t voice = totalVoices - 1; voice >= 0; voice--) {
+            state[voice] = VOICE_FREE;
+            voiceNote[voice] = 0;
+            startedAt[voice] = 0;
+            freeList[freeCount++] = voice;
+        }
+    }
+
+    void setStealMode(VoiceStealMode mode) {
+        stealMode = mode;
+    }
+
+    VoiceStealMode getStealMode() const {
+        return stealMode;
+    }
+
+    // Voice to play `note` on. levelOf(voice) returns a voice's current
+    // level and is only called to find the quietest voice.
+    template <typename LevelFn>
+    VoiceAssignment noteOn(uint8_t note, LevelFn levelOf) {
+        VoiceAssignment assignment = {VOICE_NONE, false};
+        note &= 0x7F;
+
+        int8_t previous = lastVoice[note];
+        if (stealMode == VOICE_STEAL_RETRIGGER && previous != VOICE_NONE &&
+            state[previous] != VOICE_FREE && voiceNote[previous] == note) {
+            // Same note, same voice: the envelope restarts smoothly by itself
+            assignment.voice = previous;
+            if (state[previous] == VOICE_RELEASED) {
+                state[previous] = VOICE_HELD;
+                linkHeld(previous, note);
+            }
+            startedAt[previous] = ++serial;
+            return assignment;
+        }
+
+        if (freeCount > 0) {
+            assignment.voice = freeList[--freeCount];
+        } else {
+            assignment.voice = pickVictim(levelOf);
+            if (assignment.voice == VOICE_NONE) {
+                return assignment;
+            }
+            assignment.stolen = true;
+            if (state[assignment.voice] == VOICE_HELD) {
+                unlinkHeld(assignment.voice);
+            }
+        }
+
+        int8_t voice = assignment.voice;
+        state[voice] = VOICE_HELD;
+        voiceNote[voice] = note;
+        startedAt[voice] = ++serial;
+        linkHeld(voice, note);
+        lastVoice[note] = voice;
+        return assignment;
+    }
+
+    // A voice holding `note`, now released, or VOICE_NONE once there are no
+    // more. Call until it returns VOICE_NONE.
+    int8_t noteOff(uint8_t note) {
+        int8_t voice = heldHead[note & 0x7F];
+        if (voice != VOICE_NONE) {
+            unlinkHeld(voice);
+            state[voice] = VOICE_RELEASED;
+        }
+        return voice;
+    }
+
+    // The voice's release has finished: it's free again
+    void voiceFinished(uint8_t voice) {
+        if (voice < totalVoices && state[voice] == VOICE_RELEASED) {
+            state[voice] = VOICE_FREE;
+            freeList[freeCount++] = voice;
+        }
+    }
+
+    uint8_t getFreeCount() const {
+        return freeCount;
+    }
+};
@@ -0,0 +1,503 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include "midi.h"
+#include "audio/manager.h"
+#include "audio/gen/PolyBlep.h"
+#include "audio/gen/Saw.h"
+#include "audio/gen/Tri.h"
+#include "audio/gen/Square.h"
+#include "audio/gen/Sine.h"
+#include "audio/gen/BlepSaw.h"
+#include "audio/gen/BlepSquare.h"
+#include "audio/gen/BlepTri.h"
+#include "audio/gen/Wavetable.h"
+#include "audio/mod/SVF.h"
+#include "audio/tools/fastmath.h"
+
+#define VOICE_ENGINE_MAX_VOICES 32
+
+// A stolen voice fades out over this long before its new note starts:
+// short enough to keep the timing, long enough not to click
+#define VOICE_STEAL_FADE_MS 3
+
+// Voice filter cutoff range; at the top (with no envelope or key tracking)
+// the filter is skipped
+#define VOICE_FILTER_MIN_CUTOFF 20.0f
+#define VOICE_FILTER_MAX_CUTOFF 20000.0f
+// Key tracking pivots around middle C
+#define VOICE_FILTER_KEY_CENTER 60
+
+enum VoiceWaveform : uint8_t {
+    VOICE_WAVE_SAW,
+    VOICE_WAVE_SQUARE,
+    VOICE_WAVE_TRI,
+    VOICE_WAVE_BL_SAW,
+    VOICE_WAVE_BL_SQUARE,
+    VOICE_WAVE_BL_TRI,
+    VOICE_WAVE_SINE,
+    // One Wavetable generator per voice (see setWavetables())
+    VOICE_WAVE_WAVETABLE,
+};
+
+// Polyphonic oscillator + attack/hold/release engine, laid out as struct of
+// arrays: the phase, increment, envelope level and velocity of every voice
+// sit in their own contiguous arrays, and a block is rendered voice by voice
+// in tight loops. The waveform is chosen once per block, so there are no
+// virtual calls, callbacks or per-sample state machines in the audio path.
+// Voices that finish their release are reported through takeFinished().
+//
+// The envelope ramps linearly: the attack always runs to full level, holds
+// while the gate is on, then releases to zero. A retrigger ramps up from the
+// current level instead of jumping, so it never clicks.
+//
+// Each voice also has a low-pass SVF, its cutoff set by the base cutoff, key
+// tracking and a filter envelope of its own (same shape as the amp one).
+// All of that runs at control rate, once per block: the block's end
+// coefficients are computed once and the filter slides to them sample by
+// sample, so there's one tan per voice per block, not per sample.
+class VoiceEngine {
+private:
+    enum Stage : uint8_t {
+        STAGE_IDLE,
+        STAGE_ATTACK,
+        STAGE_HOLD,
+        STAGE_RELEASE,
+        // Stolen: fading out before the pending note starts
+        STAGE_FADE,
+    };
+
+    uint8_t totalVoices = 0;
+    uint32_t sampleRate = 44100;
+    VoiceWaveform waveform = VOICE_WAVE_SAW;
+    Wavetable* wavetables = nullptr;
+
+    // Per-voice state, one array per field
+    uint32_t phase[VOICE_ENGINE_MAX_VOICES];
+    uint32_t increment[VOICE_ENGINE_MAX_VOICES];
+    float dt[VOICE_ENGINE_MAX_VOICES];
+    float level[VOICE_ENGINE_MAX_VOICES];
+    float velocity[VOICE_ENGINE_MAX_VOICES];
+    float pitchRatio[VOICE_ENGINE_MAX_VOICES];
+    float fadeStep[VOICE_ENGINE_MAX_VOICES];
+    Stage stage[VOICE_ENGINE_MAX_VOICES];
+    bool gate[VOICE_ENGINE_MAX_VOICES];
+    uint8_t note[VOICE_ENGINE_MAX_VOICES];
+
+    // Note waiting for a steal fade to finish
+    uint8_t pendingNote[VOICE_ENGINE_MAX_VOICES];
+    float pendingVelocity[VOICE_ENGINE_MAX_VOICES];
+    bool pendingNoteOff[VOICE_ENGINE_MAX_VOICES];
+
+    float attackTime = 10.0f;
+    float releaseTime = 500.0f;
+    float attackStep = 1.0f;
+    float releaseStep = 1.0f;
+    uint32_t fadeSamples = 1;
+
+    uint32_t finished = 0;
+
+    // Voice filter: SVF state, coefficients reached at the end of the last
+    // block, and the filter envelope
+    float filterIc1[VOICE_ENGINE_MAX_VOICES];
+    float filterIc2[VOICE_ENGINE_MAX_VOICES];
+    float filterA1[VOICE_ENGINE_MAX_VOICES];
+    float filterA2[VOICE_ENGINE_MAX_VOICES];
+    float filterEnvelope[VOICE_ENGINE_MAX_VOICES];
+    bool filterAttack[VOICE_ENGINE_MAX_VOICES];
+
+    float filterCutoff = VOICE_FILTER_MAX_CUTOFF;
+    float filterDamping = 2.0f;      // k = 1/Q
+    float filterEnvAmount = 0.0f;    // Octaves at full envelope
+    float filterKeyTrack = 0.0f;     // 1 follows the keyboard exactly
+    float filterAttackTime = 10.0f;
+    float filterReleaseTime = 500.0f;
+    float filterAttackStep = 1.0f;   // Per sample
+    float filterReleaseStep = 1.0f;
+    bool filterEnabled = false;
+    // Set when the filter comes back on; the next render restarts it
+    bool filterRestart = false;
+
+    void updateSteps() {
+        attackStep = 1.0f / MAX(1.0f, attackTime * sampleRate / 1000.0f);
+        releaseStep = 1.0f / MAX(1.0f, releaseTime * sampleRate / 1000.0f);
+        filterAttackStep = MIN(1.0f, 1000.0f / (filterAttackTime * sampleRate));
+        filterReleaseStep = MIN(1.0f, 1000.0f / (filterReleaseTime * sampleRate));
+    }
+
+    void updateFilterEnabled() {
+        bool wasEnabled = filterEnabled;
+        filterEnabled = filterCutoff < VOICE_FILTER_MAX_CUTOFF || filterEnvAmount != 0.0f || filterKeyTrack != 0.0f;
+        filterRestart |= filterEnabled && !wasEnabled;
+    }
+
+    // The filter stood still while it was bypassed, so its state is stale.
+    // Start it settled on the voice's current sample instead: the low-pass
+    // output then carries on from the unfiltered signal without a step.
+    void restartFilter(uint8_t voice, float input) {
+        filterIc1[voice] = 0.0f;
+        filterIc2[voice] = input;
+        filterTarget(voice, filterA1[voice], filterA2[voice]);
+    }
+
+    // Where the voice's filter should be at the end of this block
+    void filterTarget(uint8_t voice, float& a1, float& a2) const {
+        float octaves = filterEnvAmount * filterEnvelope[voice] +
+            filterKeyTrack * (note[voice] - VOICE_FILTER_KEY_CENTER) / 12.0f;
+        SVF::coefficients(filterCutoff * fastExp2(octaves), filterDamping, sampleRate, a1, a2);
+    }
+
+    // Filter envelope, moved on by `frames` samples at once. Blocks are
+    // split at MIDI events, so the step is scaled by the frames rendered
+    // rather than counted per call.
+    void advanceFilterEnvelope(uint8_t voice, size_t frames) {
+        float& env = filterEnvelope[voice];
+        if (filterAttack[voice]) {
+            env = MIN(1.0f, env + filterAttackStep * frames);
+            filterAttack[voice] = env < 1.0f;
+        } else if (!gate[voice] || stage[voice] == STAGE_FADE) {
+            env = MAX(0.0f, env - filterReleaseStep * frames);
+        }
+    }
+
+    // The coefficients glide over `frames` to where the envelope is at the
+    // end of them
+    __attribute__((hot)) void applyFilter(uint8_t voice, float* samples, size_t frames) {
+        advanceFilterEnvelope(voice, frames);
+
+        float a1, a2;
+        filterTarget(voice, a1, a2);
+        const float a1Step = (a1 - filterA1[voice]) / frames;
+        const float a2Step = (a2 - filterA2[voice]) / frames;
+        float c1 = filterA1[voice];
+        float c2 = filterA2[voice];
+        float ic1 = filterIc1[voice];
+        float ic2 = filterIc2[voice];
+
+        for (size_t n = 0; n < frames; n++) {
+            c1 += a1Step;
+            c2 += a2Step;
+            float v1 = c1 * ic1 + c2 * (samples[n] - ic2);
+            float v2 = ic2 + c2 * v1;
+            ic1 = 2.0f * v1 - ic1;
+            ic2 = 2.0f * v2 - ic2;
+            samples[n] = v2;
+        }
+
+        filterA1[voice] = a1;
+        filterA2[voice] = a2;
+        filterIc1[voice] = ic1;
+        filterIc2[voice] = ic2;
+    }
+
+    void updateFrequency(uint8_t voice) {
+        float frequency = MIDI::midiNoteToFrequency(note[voice]) * pitchRatio[voice];
+        increment[voice] = (uint32_t)(frequency * (4294967296.0f / sampleRate));
+        dt[voice] = phaseToFloat(increment[voice]);
+        if (waveform == VOICE_WAVE_WAVETABLE) {
+            wavetables[voice].setFrequency(frequency);
+        }
+    }
+
+    void start(uint8_t voice, uint8_t newNote, float newVelocity) {
+        bool silent = stage[voice] == STAGE_IDLE || level[voice] <= 0.0f;
+        note[voice] = newNote;
+        velocity[voice] = newVelocity;
+        gate[voice] = true;
+        stage[voice] = STAGE_ATTACK;
+        filterAttack[voice] = true;
+        updateFrequency(voice);
+
+        if (silent) {
+            // Nothing to glide from: start the filter fresh where it should be
+            filterIc1[voice] = 0.0f;
+            filterIc2[voice] = 0.0f;
+            filterEnvelope[voice] = 0.0f;
+            filterTarget(voice, filterA1[voice], filterA2[voice]);
+        }
+    }
+
+    template <typename Oscillator>
+    static void renderOscillator(uint32_t& voicePhase, uint32_t voiceIncrement, float voiceDt,
+                                 float* out, size_t frames) {
+        uint32_t p = voicePhase;
+        for (size_t n = 0; n < frames; n++) {
+            out[n] = Oscillator::kernel(p, voiceDt);
+            p += voiceIncrement;
+        }
+        voicePhase = p;
+    }
+
+    __attribute__((hot)) void renderVoiceOscillator(uint8_t voice, float* out, size_t frames) {
+        switch (waveform) {
+            case VOICE_WAVE_SAW:
+                renderOscillator<Saw>(phase[voice], increment[voice], dt[voice], out, frames);
+                break;
+            case VOICE_WAVE_SQUARE:
+                renderOscillator<Square>(phase[voice], increment[voice], dt[voice], out, frames);
+                break;
+            case VOICE_WAVE_TRI:
+                renderOscillator<Tri>(phase[voice], increment[voice], dt[voice], out, frames);
+                break;
+            case VOICE_WAVE_BL_SAW:
+                renderOscillator<BlepSaw>(phase[voice], increment[voice], dt[voice], out, frames);
+                break;
+            case VOICE_WAVE_BL_SQUARE:
+                renderOscillator<BlepSquare>(phase[voice], increment[voice], dt[voice], out, frames);
+                break;
+            case VOICE_WAVE_BL_TRI:
+                renderOscillator<BlepTri>(phase[voice], increment[voice], dt[voice], out, frames);
+                break;
+            case VOICE_WAVE_SINE:
+                renderOscillator<Sine>(phase[voice], increment[voice], dt[voice], out, frames);
+                break;
+            case VOICE_WAVE_WAVETABLE: {
+                // Wavetable is final, so this call is direct too
+                Wavetable& wavetable = wavetables[voice];
+                if (!wavetable.hasTables()) {
+                    // The bank couldn't be loaded
+                    memset(out, 0, frames * sizeof(float));
+                    break;
+                }
+                for (size_t n = 0; n < frames; n++) {
+                    out[n] = wavetable.getSample();
+                }
+                break;
+            }
+        }
+    }
+
+    // Mixes `oscillator` into `out` through the voice's envelope, one
+    // straight ramp segment at a time
+    __attribute__((hot)) void applyEnvelope(uint8_t voice, const float* oscillator, float* out, size_t frames) {
+        float l = level[voice];
+        const float gain = velocity[voice];
+        size_t n = 0;
+
+        while (n < frames) {
+            switch (stage[voice]) {
+                case STAGE_ATTACK: {
+                    size_t end = n + std::min(frames - n, (size_t)((1.0f - l) / attackStep) + 1);
+                    for (; n < end; n++) {
+                        l = std::min(l + attackStep, 1.0f);
+                        out[n] += oscillator[n] * l * gain;
+                    }
+                    if (l >= 1.0f) {
+                        stage[voice] = STAGE_HOLD;
+                    }
+                    break;
+                }
+
+                case STAGE_HOLD:
+                    if (!gate[voice]) {
+                        stage[voice] = STAGE_RELEASE;
+                        break;
+                    }
+                    for (; n < frames; n++) {
+                        out[n] += oscillator[n] * gain;
+                    }
+                    break;
+
+                case STAGE_RELEASE: {
+                    size_t end = n + std::min(frames - n, (size_t)(l / releaseStep) + 1);
+                    for (; n < end; n++) {
+                        l = std::max(l - releaseStep, 0.0f);
+                        out[n] += oscillator[n] * l * gain;
+                    }
+                    if (l <= 0.0f) {
+                        stage[voice] = STAGE_IDLE;
+                        finished |= 1u << voice;
+                        n = frames;
+                    }
+                    break;
+                }
+
+                case STAGE_FADE: {
+                    size_t end = n + std::min(frames - n, (size_t)(l / fadeStep[voice]) + 1);
+                    for (; n < end; n++) {
+                        l = std::max(l - fadeStep[voice], 0.0f);
+                        out[n] += oscillator[n] * l * gain;
+                    }
+                    if (l <= 0.0f) {
+                        // The new note starts with the next block
+                        start(voice, pendingNote[voice], pendingVelocity[voice]);
+                        gate[voice] = !pendingNoteOff[voice];
+                        n = frames;
+                    }
+                    break;
+                }
+
+                case STAGE_IDLE:
+                    n = frames;
+                    break;
+            }
+        }
+
+        level[voice] = l;
+    }
+
+public:
+    void init(AudioManager* audioManager, uint8_t voices) {
+        totalVoices = std::min(voices, (uint8_t)VOICE_ENGINE_MAX_VOICES);
+        sampleRate = audioManager->getDac()->getSampleRate();
+        fadeSamples = MAX(1, VOICE_STEAL_FADE_MS * sampleRate / 1000);
+        updateSteps();
+        Sine::initTable();
+
+        for (uint8_t voice = 0; voice < totalVoices; voice++) {
+            phase[voice] = 0;
+            level[voice] = 0.0f;
+            velocity[voice] = 1.0f;
+            pitchRatio[voice] = 1.0f;
+            fadeStep[voice] = 1.0f;
+            stage[voice] = STAGE_IDLE;
+            gate[voice] = false;
+            note[voice] = 48;
+            pendingNoteOff[voice] = false;
+            filterIc1[voice] = 0.0f;
+            filterIc2[voice] = 0.0f;
+            filterEnvelope[voice] = 0.0f;
+            filterAttack[voice] = false;
+            updateFrequency(voice);
+            filterTarget(voice, filterA1[voice], filterA2[voice]);
+        }
+        finished = 0;
+    }
+
+    uint8_t getTotalVoices() const {
+        return totalVoices;
+    }
+
+    // VOICE_WAVE_WAVETABLE needs setWavetables() first
+    void setWaveform(VoiceWaveform newWaveform) {
+        waveform = newWaveform;
+        for (uint8_t voice = 0; voice < totalVoices; voice++) {
+            updateFrequency(voice);
+        }
+    }
+
+    VoiceWaveform getWaveform() const {
+        return waveform;
+    }
+
+    // One initialised Wavetable per voice, for VOICE_WAVE_WAVETABLE
+    void setWavetables(Wavetable* generators) {
+        wavetables = generators;
+    }
+
+    void setAttackTime(float ms) {
+        attackTime = ms;
+        updateSteps();
+    }
+
+    void setReleaseTime(float ms) {
+        releaseTime = ms;
+        updateSteps();
+    }
+
+    // Base cutoff of the voice filter, in Hz
+    void setFilterCutoff(float cutoff) {
+        filterCutoff = std::clamp(cutoff, VOICE_FILTER_MIN_CUTOFF, VOICE_FILTER_MAX_CUTOFF);
+        updateFilterEnabled();
+    }
+
+    // 0 (none) to 1 (Q of 10)
+    void setFilterResonance(float resonance) {
+        filterDamping = 2.0f - 1.9f * std::clamp(resonance, 0.0f, 1.0f);
+    }
+
+    // How far the filter envelope opens the cutoff, in octaves
+    void setFilterEnvAmount(float octaves) {
+        filterEnvAmount = octaves;
+        updateFilterEnabled();
+    }
+
+    // 0 keeps the cutoff fixed, 1 moves it an octave per octave played
+    void setFilterKeyTrack(float amount) {
+        filterKeyTrack = amount;
+        updateFilterEnabled();
+    }
+
+    void setFilterAttackTime(float ms) {
+        filterAttackTime = ms;
+        updateSteps();
+    }
+
+    void setFilterReleaseTime(float ms) {
+        filterReleaseTime = ms;
+        updateSteps();
+    }
+
+    void noteOn(uint8_t voice, uint8_t newNote, float newVelocity) {
+        start(voice, newNote, newVelocity);
+    }
+
+    void noteOff(uint8_t voice, uint8_t offNote) {
+        if (stage[voice] == STAGE_FADE && offNote == pendingNote[voice]) {
+            pendingNoteOff[voice] = true;
+        } else if (offNote == note[voice]) {
+            gate[voice] = false;
+        }
+    }
+
+    // Fade out whatever the voice plays, then start `newNote`.
+    // Starts right away if the voice is silent.
+    void steal(uint8_t voice, uint8_t newNote, float newVelocity) {
+        if (stage[voice] == STAGE_IDLE) {
+            start(voice, newNote, newVelocity);
+            return;
+        }
+
+        pendingNote[voice] = newNote;
+        pendingVelocity[voice] = newVelocity;
+        pendingNoteOff[voice] = false;
+        fadeStep[voice] = MAX(level[voice], 1e-6f) / fadeSamples;
+        stage[voice] = STAGE_FADE;
+    }
+
+    void setPitchRatio(uint8_t voice, float ratio) {
+        pitchRatio[voice] = ratio;
+        updateFrequency(voice);
+    }
+
+    bool isActive(uint8_t voice) const {
+        return stage[voice] != STAGE_IDLE;
+    }
+
+    // Envelope level times velocity; 0 while fading out for a steal
+    float getLevel(uint8_t voice) const {
+        return stage[voice] == STAGE_FADE ? 0.0f : level[voice] * velocity[voice];
+    }
+
+    uint8_t getNote(uint8_t voice) const {
+        return note[voice];
+    }
+
+    // Voices that finished their release since the last call, as a bitmask
+    uint32_t takeFinished() {
+        uint32_t voices = finished;
+        finished = 0;
+        return voices;
+    }
+
+    // Adds all active voices into `out`
+    __attribute__((hot)) void render(float* out, size_t frames) {
+        float oscillator[AUDIO_BLOCK_SIZE];
+        for (uint8_t voice = 0; voice < totalVoices; voice++) {
+            if (stage[voice] == STAGE_IDLE) {
+                continue;
+            }
+            renderVoiceOscillator(voice, oscillator, frames);
+            if (filterEnabled) {
+                if (filterRestart) {
+                    restartFilter(voice, oscillator[0]);
+                }
+                applyFilter(voice, oscillator, frames);
+            }
+            applyEnvelope(voice, oscillator, out, frames);
+        }
+        filterRestart = false;
+    }
+};
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "psram.h"
+#include "sram.h"
+
+// How a buffer is going to be used, which decides where it's placed
+enum MemoryClass {
+    MEMORY_HOT,  // Read every sample: on-chip SRAM if it's small and the arena has room
+    MEMORY_BULK, // Long or rarely read (long delays, samples, transfer buffers): PSRAM
+};
+
+// Largest single hot buffer placed in SRAM. Anything bigger is too long to
+// gain much from it and would crowd out the short lines that do.
+#ifndef SRAM_HOT_MAX_ALLOC
+#define SRAM_HOT_MAX_ALLOC (16 * 1024)
+#endif
+
+class AudioMemory;
+AudioMemory* audio_memory_instance = nullptr;
+
+// Placement policy over the SRAM arena and PSRAM. Hot requests bigger than
+// SRAM_HOT_MAX_ALLOC go to PSRAM; ones that would fit but find the arena
+// full do too, and are counted so `sram-usage` shows when SRAM_ARENA_SIZE
+// needs revisiting.
+class AudioMemory {
+    public:
+        // `arena` is what a PSRAM placement is accounted under
+        void* alloc(uint32_t size, MemoryClass memoryClass, PSRAMArena arena = PSRAM_ARENA_APP) {
+            if (memoryClass == MEMORY_HOT && size <= SRAM_HOT_MAX_ALLOC) {
+                uint8_t* ptr = sram->alloc(size);
+                if (ptr != nullptr) {
+                    return ptr;
+                }
+                sramFallbacks++;
+            }
+            return (void*)psram->alloc(size, arena);
+        }
+
+        // Give back a buffer from alloc(), wherever it was placed
+        void free(const void* ptr) {
+            if (ptr == nullptr) {
+                return;
+            }
+            if (sram->contains(ptr)) {
+                sram->free(ptr);
+            } else {
+                psram->free(ptr);
+            }
+        }
+
+        // Frees both pools, leaving every pointer handed out dangling
+        void freeall() {
+            sram->freeall();
+            psram->freeall();
+            sramFallbacks = 0;
+        }
+
+        bool isInSram(const void* ptr) {
+            return sram->contains(ptr);
+        }
+
+        uint32_t getSramUsageInBytes() {
+            return sram->getUsageInBytes();
+        }
+
+        // Hot allocations that had to go to PSRAM since boot (or freeall())
+        uint32_t getSramFallbacks() {
+            return sramFallbacks;
+        }
+
+        static AudioMemory* getInstance() {
+            if (audio_memory_instance == nullptr) {
+                audio_memory_instance = new AudioMemory();
+            }
+            return audio_memory_instance;
+        }
+
+    private:
+        SRAMArena* sram = SRAMArena::getInstance();
+        PSRAM* psram = PSRAM::getInstance();
+        uint32_t sramFallbacks = 0;
+};
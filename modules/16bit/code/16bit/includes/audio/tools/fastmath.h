@@ -0,0 +1,121 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+// Cheap stand-ins for the libm calls on the DSP paths (the RP2350's libm
+// expf/sinf/tanf cost hundreds of cycles each). All are branch-light
+// polynomial or rational approximations with a bounded error, measured
+// against libm by `bm-bench math`:
+//
+//   fastExp2   relative error < 2e-7   x in [-126, 127]
+//   fastExp    relative error < 2e-6   |x| < 20 (x * log2(e) is rounded first)
+//   fastLog2   absolute error < 1e-6   x in [1e-6, 1]; about 1 ulp of the result beyond
+//   fastPow    relative error < 2e-6   base 1-1000, exponent -2 to 2
+//   dbToGain   relative error < 1e-6   -120 to +24 dB
+//   fastSin    absolute error < 1e-6   |x| < 2*pi; the turn reduction loses
+//   fastCos                            about |x| * 6e-8 more beyond that
+//   fastTan    relative error < 1e-6   |x| < 1.5 (cutoffs up to 0.45 * sample rate)
+//   fastTanh   absolute error < 0.025  a soft clipper, exactly +-1 past +-3
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define FASTMATH_LOG2_E 1.44269504f
+#define FASTMATH_LOG2_10 3.32192809f
+
+// 2^x
+static inline float fastExp2(float x) {
+    if (x < -126.0f) x = -126.0f;
+    if (x > 127.0f) x = 127.0f;
+
+    // Integer part into the exponent bits, fraction through a degree-5 fit
+    // of 2^f on [0, 1)
+    int32_t i = (int32_t)x - (x < 0.0f && x != (int32_t)x);
+    float f = x - i;
+    float p = 1.0f + f * (0.69315136f + f * (0.24016415f + f * (0.055800447f + f * (0.0090166879f + f * 0.0018671827f))));
+
+    uint32_t bits;
+    memcpy(&bits, &p, sizeof(bits));
+    bits += (uint32_t)i << 23;
+    memcpy(&p, &bits, sizeof(p));
+    return p;
+}
+
+// e^x
+static inline float fastExp(float x) {
+    return fastExp2(x * FASTMATH_LOG2_E);
+}
+
+// log2(x), x > 0
+static inline float fastLog2(float x) {
+    uint32_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    int32_t exponent = (int32_t)((bits >> 23) & 0xFF) - 127;
+
+    // Mantissa in [sqrt(0.5), sqrt(2)), then the atanh series of log
+    bits = (bits & 0x007FFFFF) | 0x3F800000;
+    float m;
+    memcpy(&m, &bits, sizeof(m));
+    if (m > 1.41421356f) {
+        m *= 0.5f;
+        exponent++;
+    }
+    float t = (m - 1.0f) / (m + 1.0f);
+    float t2 = t * t;
+    float series = t * (2.0f + t2 * (0.66666667f + t2 * (0.4f + t2 * 0.28571429f)));
+    return exponent + series * FASTMATH_LOG2_E;
+}
+
+// base^exponent, base > 0
+static inline float fastPow(float base, float exponent) {
+    return fastExp2(exponent * fastLog2(base));
+}
+
+// Decibels to linear gain
+static inline float dbToGain(float db) {
+    return fastExp2(db * (FASTMATH_LOG2_10 / 20.0f));
+}
+
+// `amount` 0-1 spread evenly in octaves (or any ratio) from `low` to
+// `high`, e.g. a knob to a cutoff in Hz
+static inline float expRange(float low, float high, float amount) {
+    return low * fastExp2(amount * fastLog2(high / low));
+}
+
+// sin(x) in radians
+static inline float fastSin(float x) {
+    // Down to [-pi, pi) by whole turns, then fold into [-pi/2, pi/2]
+    float turns = x * (float)(0.5 / M_PI);
+    turns -= (float)(int32_t)(turns + (turns >= 0.0f ? 0.5f : -0.5f));
+    float r = turns * (float)(2.0 * M_PI);
+    if (r > (float)(M_PI / 2)) {
+        r = (float)M_PI - r;
+    } else if (r < (float)(-M_PI / 2)) {
+        r = (float)-M_PI - r;
+    }
+
+    // Taylor to x^11: < 6e-8 on [-pi/2, pi/2]
+    float r2 = r * r;
+    return r * (1.0f + r2 * (-1.6666667e-1f + r2 * (8.3333333e-3f + r2 * (-1.9841270e-4f +
+        r2 * (2.7557319e-6f + r2 * -2.5052108e-8f)))));
+}
+
+// cos(x) in radians
+static inline float fastCos(float x) {
+    return fastSin(x + (float)(M_PI / 2));
+}
+
+// tan(x) in radians, for |x| < pi/2
+static inline float fastTan(float x) {
+    return fastSin(x) / fastSin((float)(M_PI / 2) - (x < 0.0f ? -x : x));
+}
+
+// Rational tanh, exactly +-1 from +-3 on; a soft clipper more than a tanh
+static inline float fastTanh(float x) {
+    if (x < -3.0f) return -1.0f;
+    if (x > 3.0f) return 1.0f;
+    float x2 = x * x;
+    return x * (27.0f + x2) / (27.0f + 9.0f * x2);
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <stdint.h>
+#include <math.h>
+
+// In-place radix-2 complex FFT, for building tables at load time (not for
+// the audio path). `n` must be a power of two no larger than the twiddle
+// table. Unscaled in both directions: a forward + inverse round trip
+// multiplies by n.
+class FFT {
+private:
+    // cos/sin of 2*pi*k/size for k < size/2
+    float* cosTable;
+    float* sinTable;
+    uint32_t size;
+
+public:
+    explicit FFT(uint32_t maxSize) : size(maxSize) {
+        cosTable = new float[maxSize / 2];
+        sinTable = new float[maxSize / 2];
+        for (uint32_t k = 0; k < maxSize / 2; k++) {
+            cosTable[k] = cosf(2.0f * (float)M_PI * k / maxSize);
+            sinTable[k] = sinf(2.0f * (float)M_PI * k / maxSize);
+        }
+    }
+
+    ~FFT() {
+        delete[] cosTable;
+        delete[] sinTable;
+    }
+
+    void transform(float* re, float* im, uint32_t n, bool inverse) const {
+        // Bit-reversal permutation
+        for (uint32_t i = 1, j = 0; i < n; i++) {
+            uint32_t bit = n >> 1;
+            for (; j & bit; bit >>= 1) {
+                j ^= bit;
+            }
+            j ^= bit;
+            if (i < j) {
+                float t = re[i]; re[i] = re[j]; re[j] = t;
+                t = im[i]; im[i] = im[j]; im[j] = t;
+            }
+        }
+
+        const float direction = inverse ? 1.0f : -1.0f;
+        for (uint32_t length = 2; length <= n; length <<= 1) {
+            uint32_t half = length >> 1;
+            uint32_t stride = size / length;
+            for (uint32_t start = 0; start < n; start += length) {
+                for (uint32_t k = 0; k < half; k++) {
+                    float wr = cosTable[k * stride];
+                    float wi = direction * sinTable[k * stride];
+                    uint32_t a = start + k;
+                    uint32_t b = a + half;
+                    float tr = re[b] * wr - im[b] * wi;
+                    float ti = re[b] * wi + im[b] * wr;
+                    re[b] = re[a] - tr;
+                    im[b] = im[a] - ti;
+                    re[a] += tr;
+                    im[a] += ti;
+                }
+            }
+        }
+    }
+};
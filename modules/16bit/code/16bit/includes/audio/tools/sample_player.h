@@ -1,7 +1,36 @@
 #pragma once
 #include "psram.h"
 #include "fs/pico_lfs.h"
+#include "audio/manager.h"
 
+// How much of each sample is loaded into PSRAM up front. A longer sample
+// streams the rest from flash, so this is also how long core0 may be busy
+// elsewhere right after a trigger before the tail is late.
+#ifndef SAMPLE_PRELOAD_MS
+#define SAMPLE_PRELOAD_MS 250
+#endif
+
+// Per-player ring the streamed tail is prefetched into (a power of two;
+// 16384 frames is ~370ms at 44.1kHz, 32KB)
+#ifndef SAMPLE_STREAM_RING_FRAMES
+#define SAMPLE_STREAM_RING_FRAMES 16384
+#endif
+
+// Most one stream() call reads, so update() stays short with many players
+#ifndef SAMPLE_STREAM_CHUNK_FRAMES
+#define SAMPLE_STREAM_CHUNK_FRAMES 2048
+#endif
+
+// Plays a /samples/NN.raw file (mono int16). Samples up to the preload plus
+// one ring's worth are loaded whole; longer ones keep only the head in
+// PSRAM and stream the tail: core0 calls stream() (from the app's update())
+// to read ahead of the playhead into a ring, and the audio core plays from
+// the ring. Boot only reads the heads, and the library is bounded by the
+// filesystem rather than PSRAM.
+//
+// The ring's tail position is always the same part of the same file, so
+// data read for one trigger stays good for the next, and an idle player
+// refills it from the start: a retrigger starts warm.
 class SamplePlayer {
 public:
     SamplePlayer(uint8_t sampleId): sampleId(sampleId) {
@@ -16,44 +45,197 @@ public:
         return write_file(path, data + 4, size);
     }
 
+    // Loads the sample (core0, audio stopped)
     void init() {
         PSRAM* psram = PSRAM::getInstance();
         char stream_path[32];
         snprintf(stream_path, sizeof(stream_path), "/samples/%02d.raw", sampleId);
         size_t file_size = get_file_size(stream_path);
 
-        length = MAX(0, file_size / sizeof(int16_t) - 100);
+        // The last 100 samples are skipped
+        size_t frames = file_size / sizeof(int16_t);
+        length = frames > 100 ? frames - 100 : 0;
         playhead = length; // to prevent instant playback
 
-        // Sometimes with the large files, we need to allocate at least double the size
-        // honestly, I(arunoda) don't know why this is needed.
-        // Anyway, this is a workaround. We can fix it later may be :P
-        data = (int16_t*)psram->alloc(file_size * 2);
+        // Loading again (a new upload, the app restarting) replaces the old
+        // copy instead of leaking it. The heap aligns every block, so an
+        // odd-sized file no longer leaves the next buffer misaligned.
+        closeStream();
+        psram->free(data);
+        psram->free(ring);
+        data = nullptr;
+        ring = nullptr;
+        if (length == 0) {
+            return;
+        }
+
+        size_t preloadFrames = (size_t)SAMPLE_PRELOAD_MS * AudioManager::getInstance()->getDac()->getSampleRate() / 1000;
+        headFrames = length <= preloadFrames + SAMPLE_STREAM_RING_FRAMES ? length : preloadFrames;
+
+        data = (int16_t*)psram->alloc(headFrames * sizeof(int16_t), PSRAM_ARENA_SAMPLES);
+        if (data == nullptr) {
+            length = 0;
+            return;
+        }
 
-        // Load the whole file into PSRAM
         size_t bytes_read = 0;
-        if (!read_file(stream_path, data, file_size, &bytes_read) || bytes_read != file_size) {
+        if (headFrames == length) {
+            // Short enough to keep whole
+            if (!read_file(stream_path, data, headFrames * sizeof(int16_t), &bytes_read) ||
+                bytes_read != headFrames * sizeof(int16_t)) {
+                length = 0;
+            }
+            return;
+        }
+
+        ring = (int16_t*)psram->alloc(SAMPLE_STREAM_RING_FRAMES * sizeof(int16_t), PSRAM_ARENA_SAMPLES);
+        if (ring == nullptr || !open_file(stream_path, &file)) {
             length = 0;
+            return;
         }
+        streaming = true;
+        if (!read_file_at(&file, 0, data, headFrames * sizeof(int16_t), &bytes_read) ||
+            bytes_read != headFrames * sizeof(int16_t)) {
+            closeStream();
+            length = 0;
+            return;
+        }
+
+        fillFrame = headFrames;
+        fillTrigger = triggers;
     }
 
+    // Stop streaming, e.g. before the file is rewritten (core0). Anything
+    // not prefetched yet plays as silence.
+    void closeStream() {
+        if (streaming) {
+            close_file(&file);
+            streaming = false;
+        }
+    }
+
+    // Read ahead of the playhead (core0, often: every main loop pass)
+    void stream() {
+        if (!streaming) {
+            return;
+        }
+
+        // A retrigger started over from the head. The ring still holds the
+        // start of the tail unless the last playback ran on past it.
+        uint32_t trigger = triggers;
+        __dmb();
+        size_t position = playhead;
+        if (trigger != fillTrigger) {
+            if (fillFrame > headFrames + SAMPLE_STREAM_RING_FRAMES) {
+                fillFrame = headFrames;
+            }
+            __dmb();
+            fillTrigger = trigger;
+        }
+
+        size_t limit;
+        if (position >= length) {
+            // Idle: get the start of the tail ready for the next trigger
+            if (fillFrame > headFrames + SAMPLE_STREAM_RING_FRAMES) {
+                fillFrame = headFrames;
+            }
+            limit = headFrames + SAMPLE_STREAM_RING_FRAMES;
+        } else {
+            // Never overwrite what hasn't been played yet
+            limit = position + SAMPLE_STREAM_RING_FRAMES;
+        }
+        limit = MIN(limit, length);
+
+        size_t from = fillFrame;
+        if (from >= limit) {
+            return;
+        }
+        size_t index = from & (SAMPLE_STREAM_RING_FRAMES - 1);
+        size_t count = MIN(limit - from, (size_t)SAMPLE_STREAM_CHUNK_FRAMES);
+        count = MIN(count, SAMPLE_STREAM_RING_FRAMES - index);
+
+        size_t bytes_read = 0;
+        if (!read_file_at(&file, from * sizeof(int16_t), ring + index, count * sizeof(int16_t), &bytes_read) ||
+            bytes_read != count * sizeof(int16_t)) {
+            closeStream();
+            return;
+        }
+        __dmb();
+        fillFrame = from + count;
+    }
+
+    // Audio core
     void play(float v) {
         playhead = 22;
         velocity = v;
+        __dmb();
+        triggers = triggers + 1;
     }
 
-    int16_t process() {
-        if (data != nullptr && playhead < length) {
-            return data[playhead++] * velocity;
+    // Add the next `frames` samples (normalized to -1..1) on top of out[]
+    // (audio core)
+    void mix(float* out, size_t frames) {
+        size_t position = playhead;
+        if (data == nullptr || position >= length) {
+            return;
         }
 
-        return 0;
+        size_t count = MIN(frames, length - position);
+        const float gain = velocity / 32768.0f;
+        size_t n = 0;
+
+        if (position < headFrames) {
+            size_t run = MIN(count, headFrames - position);
+            const int16_t* src = data + position;
+            for (; n < run; ++n) {
+                out[n] += src[n] * gain;
+            }
+        }
+
+        if (n < count) {
+            // Only what core0 has read for this trigger
+            size_t ready = 0;
+            if (fillTrigger == triggers) {
+                __dmb();
+                ready = fillFrame;
+                __dmb();
+            }
+            size_t end = position + count;
+            size_t available = ready > position + n ? MIN(ready, end) - position : n;
+            for (; n < available; ++n) {
+                out[n] += ring[(position + n) & (SAMPLE_STREAM_RING_FRAMES - 1)] * gain;
+            }
+            if (n < count) {
+                underruns++;
+            }
+        }
+
+        playhead = position + count;
+    }
+
+    // Blocks where the streamed tail wasn't read in time
+    uint32_t getUnderruns() const {
+        return underruns;
     }
 
 private:
     uint8_t sampleId;
-    size_t playhead = 0;
-    int16_t* data = nullptr;
+    int16_t* data = nullptr; // The head, or the whole sample
     size_t length = 0;
+    size_t headFrames = 0;
     float velocity = 1.0f;
-};
\ No newline at end of file
+
+    // Streaming
+    bool streaming = false;
+    lfs_file_t file;
+    int16_t* ring = nullptr;
+    uint32_t underruns = 0;
+
+    // Written by the audio core
+    volatile size_t playhead = 0;
+    volatile uint32_t triggers = 0;
+    // Written by core0: the tail is in the ring up to fillFrame, for the
+    // fillTrigger'th trigger
+    volatile size_t fillFrame = 0;
+    volatile uint32_t fillTrigger = 0;
+};
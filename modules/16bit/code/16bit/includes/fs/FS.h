@@ -27,17 +27,21 @@ class FS {
 
             mounted = true;
 
-            if (!createSamplesDirectory()) {
+            if (!createDirectory("/samples")) {
                 printf("Failed to create samples directory\n");
                 return false;
             }
 
+            if (!createDirectory("/wavetables")) {
+                printf("Failed to create wavetables directory\n");
+                return false;
+            }
+
             return true;
         }
 
     private:
-        bool createSamplesDirectory() {
-            const char* path = "/samples";
+        bool createDirectory(const char* path) {
             lfs_dir_t dir;
             int status = lfs_dir_open(&lfs, &dir, path);
             if (status == 0) {
@@ -1,11 +1,19 @@
 #pragma once
+#include "pico/stdlib.h"
 #include "pico_lfs.h"
 
+// How long a change made with saveLater() has to stand before it's written
+#ifndef CONFIG_SAVE_DELAY_MS
+#define CONFIG_SAVE_DELAY_MS 3000
+#endif
+
 class Config {
 private:
     int8_t length;
     const char* path;
     int8_t* store;
+    bool dirty = false;
+    uint32_t changedAtMs = 0;
 
 public:
     Config(int8_t length, const char* path) {
@@ -53,6 +61,24 @@ public:
     }
     
     void save() {
+        dirty = false;
         write_file(path, store, length);
     }
+
+    // Save once the settings have stopped changing. For changes made while
+    // audio runs: a flash write silences the audio core for its duration,
+    // so a burst of edits costs one gap, after the last one, instead of one
+    // each. Pending changes go out with saveIfIdle().
+    void saveLater() {
+        dirty = true;
+        changedAtMs = to_ms_since_boot(get_absolute_time());
+    }
+
+    // Write a saveLater() change that has stood for CONFIG_SAVE_DELAY_MS
+    // (core0, often: from the app's update())
+    void saveIfIdle() {
+        if (dirty && to_ms_since_boot(get_absolute_time()) - changedAtMs >= CONFIG_SAVE_DELAY_MS) {
+            save();
+        }
+    }
 }; 
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include "hardware/flash.h"
 #include "hardware/sync.h"
+#include "pico/multicore.h"
 #include "lfs.h"
 #include <string.h>
 #include "../utils/base64.h"
@@ -12,6 +13,9 @@ bool write_file(const char* filename, const void* data, size_t data_size);
 bool append_file(const char* filename, const void* data, size_t data_size);
 bool read_file(const char* filename, void* buffer, size_t buffer_size, size_t* bytes_read);
 bool read_file_chunk(lfs_file_t* file, void* buffer, size_t buffer_size, size_t* bytes_read);
+bool open_file(const char* filename, lfs_file_t* file);
+bool read_file_at(lfs_file_t* file, size_t offset, void* buffer, size_t buffer_size, size_t* bytes_read);
+void close_file(lfs_file_t* file);
 bool delete_file(const char* filename);
 bool list_directory(const char* path);
 bool create_directory(const char* path);
@@ -25,9 +29,43 @@ bool process_base64_file(const char* temp_filename, const char* output_filename)
 // Define the size of our filesystem (14MB in this case)
 #define FS_SIZE (14 * 1024 * 1024)
 
+// How long an erase/program waits for core1 to park before giving up
+#define FLASH_LOCKOUT_TIMEOUT_US 10000
+
 // LittleFS configuration
 static struct lfs_config littlefs_config;
 
+// Core1 renders audio straight from XIP flash and PSRAM, both behind the
+// QMI that an erase or program takes offline; touching either meanwhile
+// crashes it. Disabling interrupts only covers core0. While this is set
+// (by the audio core, once it's a lockout victim), every erase/program
+// parks core1 in RAM first. Audio output runs on by DMA without core1, and
+// flash_parked_callback (set by the audio manager) points it at silence, so
+// a write while audio runs is a silent gap rather than a crash or noise.
+volatile bool flash_lockout_core1 = false;
+void (*flash_parked_callback)() = nullptr;
+
+// Park core1 if it's running audio. `locked` says whether to release it
+// afterwards.
+static bool flash_lock_core1(bool* locked) {
+    *locked = flash_lockout_core1;
+    if (*locked && !multicore_lockout_start_timeout_us(FLASH_LOCKOUT_TIMEOUT_US)) {
+        printf("Flash write skipped: the audio core didn't stop\n");
+        *locked = false;
+        return false;
+    }
+    if (*locked && flash_parked_callback != nullptr) {
+        flash_parked_callback();
+    }
+    return true;
+}
+
+static void flash_unlock_core1(bool locked) {
+    if (locked) {
+        multicore_lockout_end_blocking();
+    }
+}
+
 // Flash read operation for LittleFS
 static int flash_read(const struct lfs_config *c, lfs_block_t block,
                      lfs_off_t off, void *buffer, lfs_size_t size) {
@@ -61,7 +99,12 @@ static int flash_write(const struct lfs_config *c, lfs_block_t block,
     // Update the block with new data
     memcpy(block_buffer + off, buffer, size);
     
-    // Disable interrupts during flash operations
+    // Park core1, then disable interrupts during flash operations
+    bool locked;
+    if (!flash_lock_core1(&locked)) {
+        free(block_buffer);
+        return LFS_ERR_IO;
+    }
     uint32_t ints = save_and_disable_interrupts();
     
     // Erase the block
@@ -72,6 +115,7 @@ static int flash_write(const struct lfs_config *c, lfs_block_t block,
     
     // Restore interrupts
     restore_interrupts(ints);
+    flash_unlock_core1(locked);
     
     // Free the temporary buffer
     free(block_buffer);
@@ -84,7 +128,11 @@ static int flash_erase(const struct lfs_config *c, lfs_block_t block) {
     // Calculate the actual flash address
     uint32_t addr = FS_FLASH_OFFSET + (block * c->block_size);
     
-    // Disable interrupts during flash operations
+    // Park core1, then disable interrupts during flash operations
+    bool locked;
+    if (!flash_lock_core1(&locked)) {
+        return LFS_ERR_IO;
+    }
     uint32_t ints = save_and_disable_interrupts();
     
     // Erase the block
@@ -92,6 +140,7 @@ static int flash_erase(const struct lfs_config *c, lfs_block_t block) {
     
     // Restore interrupts
     restore_interrupts(ints);
+    flash_unlock_core1(locked);
     
     return 0; // Success
 }
@@ -275,6 +324,23 @@ bool read_file_chunk(lfs_file_t* file, void* buffer, size_t buffer_size, size_t*
     return true;
 }
 
+// Open a file for reading with read_file_at(), kept open until close_file()
+bool open_file(const char* filename, lfs_file_t* file) {
+    return lfs_file_open(&lfs, file, filename, LFS_O_RDONLY) == 0;
+}
+
+// Read from `offset` in an already opened file
+bool read_file_at(lfs_file_t* file, size_t offset, void* buffer, size_t buffer_size, size_t* bytes_read) {
+    if (lfs_file_seek(&lfs, file, offset, LFS_SEEK_SET) < 0) {
+        return false;
+    }
+    return read_file_chunk(file, buffer, buffer_size, bytes_read);
+}
+
+void close_file(lfs_file_t* file) {
+    lfs_file_close(&lfs, file);
+}
+
 // Delete a file from the filesystem
 bool delete_file(const char* filename) {
     int err = lfs_remove(&lfs, filename);
@@ -2,11 +2,9 @@
 
 #include <math.h>
 #include "pico/stdlib.h"
-#include "hardware/adc.h"
 #include "audio/manager.h"
+#include "audio/adc_capture.h"
 
-#define CV1_PIN 2
-#define CV2_PIN 3
 #define LED_PIN 13
 #define BUTTON_PIN 12
 
@@ -37,7 +35,7 @@ class IO {
         bool buttonPressed = false;
         bool firstRun = true;
 
-        AudioManager* audioManager = AudioManager::getInstance();
+        AdcCapture* adcCapture = AdcCapture::getInstance();
 
         void (*buttonPressedCallback)(bool) = nullptr;
 
@@ -53,11 +51,8 @@ class IO {
             return io_instance;
         }
 
+        // CVs come from AdcCapture, started by AudioManager::init()
         void init() {
-            adc_init();
-            adc_gpio_init(26 + CV1_PIN);
-            adc_gpio_init(26 + CV2_PIN);
-
             gpio_init(LED_PIN);
             gpio_set_dir(LED_PIN, GPIO_OUT);
 
@@ -130,13 +125,11 @@ class IO {
                 }
             }
 
-            if (currentTime - lastReadTime >= 1) {
+            if (currentTime - lastReadTime >= 1 && adcCapture->isRunning()) {
                 lastReadTime = currentTime;
-                
-                audioManager->startAdcLock();
+
                 // handle cv1 changes
-                adc_select_input(CV1_PIN);
-                uint16_t newCv1Value = adc_read();
+                uint16_t newCv1Value = adcCapture->readCV1();
 
                 if (firstRun || (abs(cv1Value - newCv1Value) > cv1DiffThreshold)) {
                     cv1Value = newCv1Value;
@@ -146,9 +139,7 @@ class IO {
                 }
 
                 // handle cv2 changes
-                adc_select_input(CV2_PIN);
-                uint16_t newCv2Value = adc_read();
-                audioManager->endAdcLock();
+                uint16_t newCv2Value = adcCapture->readCV2();
 
                 if (firstRun || (abs(cv2Value - newCv2Value) > cv2DiffThreshold)) {
                     cv2Value = newCv2Value;
@@ -28,6 +28,55 @@
 #define MIDI_REALTIME_ACTIVE_SENSING 0xFE
 #define MIDI_REALTIME_RESET    0xFF
 
+// Pitch bend is 14 bits, centred here
+#define MIDI_PITCH_BEND_CENTER 8192
+
+// Fine pitch table resolution: steps per semitone (power of two)
+#define MIDI_FINE_PITCH_BITS 6
+#define MIDI_FINE_PITCH_STEPS (1 << MIDI_FINE_PITCH_BITS)
+
+// 2^x for the compile-time pitch tables (Taylor series, double precision)
+constexpr double midiExp2(double x) {
+    int whole = (int)x;
+    if (x < whole) {
+        whole--;
+    }
+    double fraction = (x - whole) * 0.69314718055994530942;
+    double term = 1.0;
+    double sum = 1.0;
+    for (int n = 1; n < 24; n++) {
+        term *= fraction / n;
+        sum += term;
+    }
+    for (; whole > 0; whole--) {
+        sum *= 2.0;
+    }
+    for (; whole < 0; whole++) {
+        sum *= 0.5;
+    }
+    return sum;
+}
+
+typedef struct {
+    // Equal temperament, A4 (note 69) = 440Hz
+    float noteFrequency[128];
+    // 2^(i / (12 * MIDI_FINE_PITCH_STEPS)): one semitone, plus a guard point
+    float fineRatio[MIDI_FINE_PITCH_STEPS + 1];
+} MidiPitchTables;
+
+constexpr MidiPitchTables makeMidiPitchTables() {
+    MidiPitchTables tables = {};
+    for (int note = 0; note < 128; note++) {
+        tables.noteFrequency[note] = (float)(440.0 * midiExp2((note - 69) / 12.0));
+    }
+    for (int i = 0; i <= MIDI_FINE_PITCH_STEPS; i++) {
+        tables.fineRatio[i] = (float)midiExp2(i / (12.0 * MIDI_FINE_PITCH_STEPS));
+    }
+    return tables;
+}
+
+constexpr MidiPitchTables midiPitchTables = makeMidiPitchTables();
+
 class MIDI;
 MIDI* midi_instance = nullptr;
 
@@ -43,6 +92,8 @@ private:
     using NoteOnCallback = std::function<void(uint8_t channel, uint8_t note, uint8_t velocity)>;
     using NoteOffCallback = std::function<void(uint8_t channel, uint8_t note, uint8_t velocity)>;
     using ControlChangeCallback = std::function<void(uint8_t channel, uint8_t controller, uint8_t value)>;
+    // bend is -8192..8191, 0 is centred
+    using PitchBendCallback = std::function<void(uint8_t channel, int16_t bend)>;
     // Real-time callback type
     using RealtimeCallback = std::function<void(uint8_t realtimeType)>;
     using BpmChangeCallback = std::function<void(uint16_t bpm)>;
@@ -51,6 +102,7 @@ private:
     NoteOnCallback note_on_callback;
     NoteOffCallback note_off_callback;
     ControlChangeCallback cc_callback;
+    PitchBendCallback pitch_bend_callback;
     // Real-time callback
     RealtimeCallback realtime_callback;
 
@@ -154,6 +206,12 @@ public:
                                 cc_callback(channel, data1, data2);
                             }
                             break;
+                        case MIDI_PITCH_BEND:
+                            // LSB first, 7 bits each
+                            if (pitch_bend_callback) {
+                                pitch_bend_callback(channel, (int16_t)((data2 << 7) | data1) - MIDI_PITCH_BEND_CENTER);
+                            }
+                            break;
                         default:
                             // Unknown MIDI message type
                             break;
@@ -175,6 +233,10 @@ public:
     void setControlChangeCallback(ControlChangeCallback callback) {
         cc_callback = callback;
     }
+
+    void setPitchBendCallback(PitchBendCallback callback) {
+        pitch_bend_callback = callback;
+    }
     
     // Set real-time callback
     void setRealtimeCallback(RealtimeCallback callback) {
@@ -217,9 +279,30 @@ public:
         return midi_instance;
     }
 
-    static uint16_t midiNoteToFrequency(uint8_t note) {
-        // Convert MIDI note number to frequency
-        return 440 * pow(2, (note - 69) / 12.0);
+    static float midiNoteToFrequency(uint8_t note) {
+        return midiPitchTables.noteFrequency[note & 0x7F];
+    }
+
+    // Frequency ratio of an offset in semitones (pitch bend, detune).
+    // Whole semitones come from the note table, the rest is interpolated
+    // from the fine table, so the resolution is well below a cent.
+    static float semitonesToRatio(float semitones) {
+        float position = semitones * MIDI_FINE_PITCH_STEPS;
+        int32_t step = (int32_t)floorf(position);
+        float fraction = position - step;
+
+        int32_t semitone = step >> MIDI_FINE_PITCH_BITS;
+        uint32_t fine = step & (MIDI_FINE_PITCH_STEPS - 1);
+        semitone = semitone < -69 ? -69 : (semitone > 58 ? 58 : semitone);
+
+        float a = midiPitchTables.fineRatio[fine];
+        float b = midiPitchTables.fineRatio[fine + 1];
+        return midiPitchTables.noteFrequency[69 + semitone] * (1.0f / 440.0f) * (a + (b - a) * fraction);
+    }
+
+    // Pitch bend (-8192..8191) to semitones for a +/-`range` semitone wheel
+    static float pitchBendToSemitones(int16_t bend, float range) {
+        return bend * (range / MIDI_PITCH_BEND_CENTER);
     }
     
     // Enable BPM calculation and set callback
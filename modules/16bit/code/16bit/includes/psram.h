@@ -2,8 +2,33 @@
 
 #include "pico/stdlib.h"
 #include "hardware/structs/xip.h"
+#include "utils/heap.h"
 
-volatile uint8_t* PSRAM_BASE = (volatile uint8_t*)0x11000000;
+// PSRAM is mapped into the XIP M1 window (host builds point this at a plain buffer)
+#ifndef PSRAM_BASE_ADDR
+#define PSRAM_BASE_ADDR 0x11000000
+#endif
+
+#ifndef PSRAM_SIZE
+#define PSRAM_SIZE (8 * 1024 * 1024)
+#endif
+
+// Most live allocations at once (each sample, wavetable and delay line is one)
+#ifndef PSRAM_MAX_BLOCKS
+#define PSRAM_MAX_BLOCKS 128
+#endif
+
+volatile uint8_t* PSRAM_BASE = (volatile uint8_t*)PSRAM_BASE_ADDR;
+
+// What an allocation is for. Usage is reported per arena (`psram-arenas`)
+// and an arena can be freed in one go.
+enum PSRAMArena {
+    PSRAM_ARENA_APP,      // Anything not below
+    PSRAM_ARENA_FX,       // Delay lines
+    PSRAM_ARENA_SAMPLES,  // Samples and wavetables loaded from flash
+    PSRAM_ARENA_TRANSFER, // WebSerial upload buffers
+    PSRAM_ARENA_COUNT
+};
 
 class PSRAM;
 PSRAM* psram_instance = nullptr;
@@ -11,7 +36,7 @@ PSRAM* psram_instance = nullptr;
 class PSRAM {
     public:
         PSRAM() {
-
+            heap.init((uint8_t*)PSRAM_BASE, PSRAM_SIZE);
         }
 
         void init() {
@@ -20,16 +45,41 @@ class PSRAM {
             xip_ctrl_hw->ctrl |= XIP_CTRL_WRITABLE_M1_BITS;
         }
 
-        // We have a very simple allocator, so we need to free all the memory when we're done
-        volatile uint8_t* alloc(uint32_t size) {
-            volatile uint8_t* ptr = PSRAM_BASE + current_position;
-            current_position += size;
+        // HEAP_ALIGNMENT-aligned; nullptr (and a message) when it doesn't fit
+        volatile uint8_t* alloc(uint32_t size, PSRAMArena arena = PSRAM_ARENA_APP) {
+            uint8_t* ptr = heap.alloc(size, arena);
+            if (ptr == nullptr) {
+                HeapStats stats = heap.getStats();
+                printf("PSRAM: no room for %u bytes (%u free, largest %u)\n",
+                       (unsigned)size, (unsigned)stats.freeBytes, (unsigned)stats.largestFreeBytes);
+            }
             return ptr;
         }
 
-        // We have a very simple allocator, so we need to free all the memory when we're done
+        // Give back one allocation (nullptr is ignored)
+        void free(const volatile void* ptr) {
+            if (ptr != nullptr) {
+                heap.free((const void*)ptr);
+            }
+        }
+
+        void freeArena(PSRAMArena arena) {
+            heap.freeTag(arena);
+        }
+
+        // Frees everything, leaving every pointer handed out dangling
         void freeall() {
-            current_position = 0;
+            heap.freeall();
+        }
+
+        static const char* getArenaName(PSRAMArena arena) {
+            switch (arena) {
+                case PSRAM_ARENA_APP: return "app";
+                case PSRAM_ARENA_FX: return "fx";
+                case PSRAM_ARENA_SAMPLES: return "samples";
+                case PSRAM_ARENA_TRANSFER: return "transfer";
+                default: return "";
+            }
         }
 
         static PSRAM* getInstance() {
@@ -40,9 +90,17 @@ class PSRAM {
         }
 
         uint32_t getUsageInBytes() {
-            return current_position;
+            return heap.getUsageInBytes();
+        }
+
+        uint32_t getUsageInBytes(PSRAMArena arena) {
+            return heap.getUsageInBytes(arena);
+        }
+
+        HeapStats getStats() {
+            return heap.getStats();
         }
 
     private:
-        uint32_t current_position = 0;
+        RegionHeap<PSRAM_MAX_BLOCKS> heap;
 };
\ No newline at end of file
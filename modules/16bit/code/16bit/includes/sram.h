@@ -0,0 +1,63 @@
+#pragma once
+
+#include "pico/stdlib.h"
+#include "utils/heap.h"
+
+// On-chip SRAM set aside for small buffers the audio path reads every sample
+// (short delay/allpass/comb lines). The rest of the 520KB holds the stacks,
+// heap and DMA buffers, so keep this budget modest.
+#ifndef SRAM_ARENA_SIZE
+#define SRAM_ARENA_SIZE (64 * 1024)
+#endif
+
+#ifndef SRAM_ARENA_MAX_BLOCKS
+#define SRAM_ARENA_MAX_BLOCKS 32
+#endif
+
+alignas(8) uint8_t sram_arena[SRAM_ARENA_SIZE];
+
+class SRAMArena;
+SRAMArena* sram_arena_instance = nullptr;
+
+class SRAMArena {
+    public:
+        SRAMArena() {
+            heap.init(sram_arena, SRAM_ARENA_SIZE);
+        }
+
+        // Returns nullptr once the budget is used up, so the caller can fall
+        // back to PSRAM (see AudioMemory)
+        uint8_t* alloc(uint32_t size) {
+            return heap.alloc(size, 0);
+        }
+
+        void free(const void* ptr) {
+            heap.free(ptr);
+        }
+
+        void freeall() {
+            heap.freeall();
+        }
+
+        bool contains(const void* ptr) {
+            return heap.contains(ptr);
+        }
+
+        static SRAMArena* getInstance() {
+            if (sram_arena_instance == nullptr) {
+                sram_arena_instance = new SRAMArena();
+            }
+            return sram_arena_instance;
+        }
+
+        uint32_t getUsageInBytes() {
+            return heap.getUsageInBytes();
+        }
+
+        HeapStats getStats() {
+            return heap.getStats();
+        }
+
+    private:
+        RegionHeap<SRAM_ARENA_MAX_BLOCKS> heap;
+};
@@ -0,0 +1,219 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// Only core0 may call into a heap (see RegionHeap). The host renderer runs
+// on one thread and its shim reports the audio core, so it isn't checked there.
+#ifdef BM_HOST
+#define HEAP_CHECK_CORE()
+#else
+#include "pico/stdlib.h"
+#define HEAP_CHECK_CORE() hard_assert(get_core_num() == 0)
+#endif
+
+// Every block starts on this boundary, so int16/float/double buffers can
+// follow one another without needing padding by the caller
+#ifndef HEAP_ALIGNMENT
+#define HEAP_ALIGNMENT 8
+#endif
+
+typedef struct {
+    uint32_t usedBytes;
+    uint32_t freeBytes;
+    uint32_t largestFreeBytes; // Biggest allocation that would still succeed
+    uint32_t highWaterBytes;   // Most ever in use at once
+    uint16_t usedBlocks;
+    uint16_t freeBlocks;
+    uint32_t failedAllocs;
+} HeapStats;
+
+// Best-fit allocator over a fixed memory region (PSRAM, an SRAM arena).
+// The block list lives here, not in the region, so allocating and freeing
+// never touch the memory being managed; it's kept sorted by address so
+// freed blocks merge with free neighbours. Every block carries a tag (an
+// arena id) so usage can be reported, and freed, per arena.
+// Not thread safe, so only core0 allocates and frees, with or without the
+// audio running. The audio core never calls in: it only reads and writes
+// buffers it was handed, and core0 frees one only once the audio core has
+// let go of it (FXSlot hands retired effects back through collect(), sample
+// and wavetable reloads stop the audio first).
+template <uint16_t MAX_BLOCKS>
+class RegionHeap {
+    public:
+        void init(uint8_t* base, uint32_t size) {
+            this->base = base;
+            this->size = size;
+            highWaterBytes = 0;
+            failedAllocs = 0;
+            freeall();
+        }
+
+        uint8_t* alloc(uint32_t bytes, uint8_t tag) {
+            HEAP_CHECK_CORE();
+            bytes = (bytes + HEAP_ALIGNMENT - 1) & ~(uint32_t)(HEAP_ALIGNMENT - 1);
+            if (bytes == 0) {
+                bytes = HEAP_ALIGNMENT;
+            }
+
+            // Best fit keeps the big free areas whole for big samples
+            int best = -1;
+            for (uint16_t i = 0; i < count; i++) {
+                if (!blocks[i].used && blocks[i].size >= bytes &&
+                    (best < 0 || blocks[i].size < blocks[best].size)) {
+                    best = i;
+                }
+            }
+            if (best < 0) {
+                failedAllocs++;
+                return nullptr;
+            }
+
+            if (count == MAX_BLOCKS) {
+                // No room to track a remainder: hand out the whole block
+                bytes = blocks[best].size;
+            } else if (blocks[best].size > bytes) {
+                // Split: the remainder stays free right after the new block
+                memmove(&blocks[best + 2], &blocks[best + 1], (count - best - 1) * sizeof(Block));
+                blocks[best + 1] = {blocks[best].offset + bytes, blocks[best].size - bytes, 0, false};
+                blocks[best].size = bytes;
+                count++;
+            }
+            blocks[best].used = true;
+            blocks[best].tag = tag;
+
+            usedBytes += bytes;
+            if (usedBytes > highWaterBytes) {
+                highWaterBytes = usedBytes;
+            }
+            return base + blocks[best].offset;
+        }
+
+        // False if `ptr` isn't the start of an allocated block
+        bool free(const void* ptr) {
+            HEAP_CHECK_CORE();
+            int i = find(ptr);
+            if (i < 0) {
+                return false;
+            }
+            release(i);
+            return true;
+        }
+
+        // Free everything allocated with `tag`
+        void freeTag(uint8_t tag) {
+            HEAP_CHECK_CORE();
+            for (int i = count - 1; i >= 0; i--) {
+                // Merging only removes blocks from i - 1 on, which the
+                // loop has already passed or is about to look at
+                if (blocks[i].used && blocks[i].tag == tag) {
+                    release(i);
+                }
+            }
+        }
+
+        void freeall() {
+            HEAP_CHECK_CORE();
+            blocks[0] = {0, size, 0, false};
+            count = 1;
+            usedBytes = 0;
+        }
+
+        bool contains(const void* ptr) const {
+            return (const uint8_t*)ptr >= base && (const uint8_t*)ptr < base + size;
+        }
+
+        uint32_t getUsageInBytes() const {
+            return usedBytes;
+        }
+
+        uint32_t getUsageInBytes(uint8_t tag) const {
+            uint32_t total = 0;
+            for (uint16_t i = 0; i < count; i++) {
+                if (blocks[i].used && blocks[i].tag == tag) {
+                    total += blocks[i].size;
+                }
+            }
+            return total;
+        }
+
+        uint32_t getSize() const {
+            return size;
+        }
+
+        HeapStats getStats() const {
+            HeapStats stats = {};
+            stats.usedBytes = usedBytes;
+            stats.freeBytes = size - usedBytes;
+            stats.highWaterBytes = highWaterBytes;
+            stats.failedAllocs = failedAllocs;
+            for (uint16_t i = 0; i < count; i++) {
+                if (blocks[i].used) {
+                    stats.usedBlocks++;
+                } else {
+                    stats.freeBlocks++;
+                    if (blocks[i].size > stats.largestFreeBytes) {
+                        stats.largestFreeBytes = blocks[i].size;
+                    }
+                }
+            }
+            return stats;
+        }
+
+    private:
+        typedef struct {
+            uint32_t offset;
+            uint32_t size;
+            uint8_t tag;
+            bool used;
+        } Block;
+
+        uint8_t* base = nullptr;
+        uint32_t size = 0;
+        Block blocks[MAX_BLOCKS];
+        uint16_t count = 0;
+        uint32_t usedBytes = 0;
+        uint32_t highWaterBytes = 0;
+        uint32_t failedAllocs = 0;
+
+        int find(const void* ptr) const {
+            if (!contains(ptr)) {
+                return -1;
+            }
+            uint32_t offset = (const uint8_t*)ptr - base;
+            int low = 0, high = count - 1;
+            while (low <= high) {
+                int mid = (low + high) / 2;
+                if (blocks[mid].offset == offset) {
+                    return blocks[mid].used ? mid : -1;
+                }
+                if (blocks[mid].offset < offset) {
+                    low = mid + 1;
+                } else {
+                    high = mid - 1;
+                }
+            }
+            return -1;
+        }
+
+        // Mark block i free and merge it with free neighbours
+        void release(int i) {
+            blocks[i].used = false;
+            usedBytes -= blocks[i].size;
+
+            if (i + 1 < count && !blocks[i + 1].used) {
+                blocks[i].size += blocks[i + 1].size;
+                remove(i + 1);
+            }
+            if (i > 0 && !blocks[i - 1].used) {
+                blocks[i - 1].size += blocks[i].size;
+                remove(i);
+            }
+        }
+
+        void remove(int i) {
+            memmove(&blocks[i], &blocks[i + 1], (count - i - 1) * sizeof(Block));
+            count--;
+        }
+};
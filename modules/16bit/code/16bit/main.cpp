@@ -5,8 +5,9 @@
 
 #include "io.h"
 #include "midi.h"
-#include "fs/fs.h"
+#include "fs/FS.h"
 #include "psram.h"
+#include "audio/tools/audio_memory.h"
 #include "audio/manager.h"
 #include "api/web_serial.h"
 #include "fs/config.h"
@@ -50,6 +51,7 @@
 FS *fs = FS::getInstance();
 IO *io = IO::getInstance();
 PSRAM *psram = PSRAM::getInstance();
+AudioMemory *audioMemory = AudioMemory::getInstance();
 AudioManager *audioManager = AudioManager::getInstance();
 MIDI *midi = MIDI::getInstance();
 WebSerial* webSerial = WebSerial::getInstance();
@@ -73,41 +75,81 @@ void loadApp() {
     #endif
 }
 
+// Buffers are owned by whatever uses them and reallocated in place, so a
+// restart doesn't need to wipe PSRAM first
 void onAudioStartCallback() {
-    psram->freeall();
     app->init();
 }
 
-void audioCallback(AudioInput *input, AudioOutput *output) {
-    app->audioCallback(input, output);
+void audioCallback(const AudioInput* input, AudioOutput* output, size_t frames) {
+    app->processBlock(input, output, frames);
+}
+
+// MIDI, CV and BPM changes are queued to core1 and applied between blocks,
+// so the app callbacks never race the audio callback.
+void audioEventHandler(const AudioEvent& event) {
+    switch (event.type) {
+        case AUDIO_EVENT_NOTE_ON:
+            app->noteOnCallback(event.channel, event.data1, event.data2);
+            break;
+        case AUDIO_EVENT_NOTE_OFF:
+            app->noteOffCallback(event.channel, event.data1, event.data2);
+            break;
+        case AUDIO_EVENT_CC:
+            app->ccChangeCallback(event.channel, event.data1, event.data2);
+            break;
+        case AUDIO_EVENT_CV1:
+            app->cv1UpdateCallback(event.value);
+            break;
+        case AUDIO_EVENT_CV2:
+            app->cv2UpdateCallback(event.value);
+            break;
+        case AUDIO_EVENT_BPM:
+            app->bpmChangeCallback(event.value);
+            break;
+        case AUDIO_EVENT_PITCH_BEND:
+            app->pitchBendCallback(event.channel, (int16_t)event.value - MIDI_PITCH_BEND_CENTER);
+            break;
+        default:
+            break;
+    }
 }
 
 void noteOnCallback(uint8_t channel, uint8_t note, uint8_t velocity) {
-    app->noteOnCallback(channel, note, velocity);
+    audioManager->postEvent(AUDIO_EVENT_NOTE_ON, channel, note, velocity);
 }
 
 void noteOffCallback(uint8_t channel, uint8_t note, uint8_t velocity) {
-    app->noteOffCallback(channel, note, velocity);
+    audioManager->postEvent(AUDIO_EVENT_NOTE_OFF, channel, note, velocity);
 }
 
 void ccChangeCallback(uint8_t channel, uint8_t cc, uint8_t value) {
-    app->ccChangeCallback(channel, cc, value);
+    audioManager->postEvent(AUDIO_EVENT_CC, channel, cc, value);
 }
 
+void pitchBendCallback(uint8_t channel, int16_t bend) {
+    AudioEvent event = {};
+    event.type = AUDIO_EVENT_PITCH_BEND;
+    event.channel = channel;
+    event.value = bend + MIDI_PITCH_BEND_CENTER;
+    audioManager->postEvent(event);
+}
+
+// Stays on core0: apps may stop/start the audio engine from here
 void buttonPressedCallback(bool pressed) {
     app->buttonPressedCallback(pressed);
 }
 
 void cv1UpdateCallback(uint16_t cv1) {
-    app->cv1UpdateCallback(cv1);
+    audioManager->postValue(AUDIO_EVENT_CV1, cv1);
 }
 
 void cv2UpdateCallback(uint16_t cv2) {
-    app->cv2UpdateCallback(cv2);
+    audioManager->postValue(AUDIO_EVENT_CV2, cv2);
 }
 
 void bpmChangeCallback(int bpm) {
-    app->bpmChangeCallback(bpm);
+    audioManager->postValue(AUDIO_EVENT_BPM, bpm);
 }
 
 bool onCommandCallback(const char* cmd) {
@@ -143,6 +185,77 @@ bool onCommandCallback(const char* cmd) {
         return true;
     }
 
+    if (strncmp(cmd, "psram-stats", 11) == 0) {
+        HeapStats stats = psram->getStats();
+        int values[] = {
+            (int)stats.usedBytes,
+            (int)stats.freeBytes,
+            (int)stats.largestFreeBytes,
+            (int)stats.highWaterBytes,
+            (int)stats.usedBlocks,
+            (int)stats.freeBlocks,
+            (int)stats.failedAllocs,
+        };
+        webSerial->sendList(values, 7);
+        return true;
+    }
+
+    // Bytes in use per PSRAMArena, in enum order
+    if (strncmp(cmd, "psram-arenas", 12) == 0) {
+        int values[PSRAM_ARENA_COUNT];
+        for (int arena = 0; arena < PSRAM_ARENA_COUNT; arena++) {
+            values[arena] = (int)psram->getUsageInBytes((PSRAMArena)arena);
+        }
+        webSerial->sendList(values, PSRAM_ARENA_COUNT);
+        return true;
+    }
+
+    // SRAM arena: bytes in use, budget, hot buffers that didn't fit
+    if (strncmp(cmd, "sram-usage", 10) == 0) {
+        int values[] = {
+            (int)audioMemory->getSramUsageInBytes(),
+            SRAM_ARENA_SIZE,
+            (int)audioMemory->getSramFallbacks(),
+        };
+        webSerial->sendList(values, 3);
+        return true;
+    }
+
+    // Render load over the last ~1s, in % of the block period: min, avg, p99, max
+    if (strncmp(cmd, "cpu-load", 8) == 0) {
+        AudioLoadStats stats = audioManager->getLoadStats();
+        // No budget yet before the first window (or with audio stopped): all 0
+        float scale = stats.budgetCycles > 0 ? 100.0f / stats.budgetCycles : 0.0f;
+        float load[] = {
+            stats.minCycles * scale,
+            stats.avgCycles * scale,
+            stats.p99Cycles * scale,
+            stats.maxCycles * scale,
+        };
+        webSerial->sendList(load, 4);
+        return true;
+    }
+
+    // Render times in us plus deadline counters, see the Serial API table in README.md
+    if (strncmp(cmd, "audio-stats", 11) == 0) {
+        AudioLoadStats stats = audioManager->getLoadStats();
+        uint32_t cyclesPerUs = clock_get_hz(clk_sys) / 1000000;
+        int values[] = {
+            (int)audioManager->getBlockSize(),
+            (int)(stats.budgetCycles / cyclesPerUs),
+            (int)(stats.minCycles / cyclesPerUs),
+            (int)(stats.avgCycles / cyclesPerUs),
+            (int)(stats.p99Cycles / cyclesPerUs),
+            (int)(stats.maxCycles / cyclesPerUs),
+            (int)stats.totalBlocks,
+            (int)stats.overruns,
+            (int)audioManager->getUnderruns(),
+            (int)audioManager->getDroppedEvents(),
+        };
+        webSerial->sendList(values, 10);
+        return true;
+    }
+
     // This is the API version as we increase when we make new changes to the API
     if (strncmp(cmd, "version", 7) == 0) {
         webSerial->sendValue(PICO_PROGRAM_VERSION_STRING);
@@ -176,11 +289,13 @@ int main() {
 
     audioManager->setOnAudioStartCallback(onAudioStartCallback);
     audioManager->setAudioCallback(audioCallback);
+    audioManager->setAudioEventHandler(audioEventHandler);
     audioManager->init(SAMPLE_RATE);
 
     // Set up BPM calculation and print BPM when it changes
     midi->calculateBPM(bpmChangeCallback);
     midi->setControlChangeCallback(ccChangeCallback);
+    midi->setPitchBendCallback(pitchBendCallback);
     midi->setNoteOnCallback(noteOnCallback);
     midi->setNoteOffCallback(noteOffCallback);
     midi->init();
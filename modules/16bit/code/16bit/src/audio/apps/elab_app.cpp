@@ -15,32 +15,36 @@ void ElabApp::init() {
 }
 
 __attribute__((hot))
-void ElabApp::audioCallback(AudioInput *input, AudioOutput *output) {
+void ElabApp::processBlock(const AudioInput* input, AudioOutput* output, size_t frames) {
     // This app only processes audio when active; no extra guard needed.
-    float waveform = sawWaveform.getSample();
-    float subWaveform = subSawWaveform.getSample();
+    uint32_t sampleRate = audioManager->getDac()->getSampleRate();
 
-    // Maintain the sample counter
-    sampleCounter++;
-    if (sampleCounter > audioManager->getDac()->getSampleRate()) {
-        sampleCounter = 0;
-    }
+    for (size_t n = 0; n < frames; n++) {
+        float waveform = sawWaveform.getSample();
+        float subWaveform = subSawWaveform.getSample();
 
-    if (sampleCounter % sampleAt == 0) {
-        // TODO: We need to sample the ADC here
-        a1Samples[a1SampleIndex] = (input->left + 1) / 2.0 * 255;
-        a1SampleIndex++;
-        if (a1SampleIndex > sampleCount) {
-            flushNow = true;
-            a1SampleIndex = 0;
-            uint8_t *tempBuffer = a1FlushSamples;
-            a1FlushSamples = a1Samples;
-            a1Samples = tempBuffer;
+        // Maintain the sample counter
+        sampleCounter++;
+        if (sampleCounter > sampleRate) {
+            sampleCounter = 0;
+        }
+
+        if (sampleCounter % sampleAt == 0) {
+            // TODO: We need to sample the ADC here
+            a1Samples[a1SampleIndex] = (input[n].left + 1) / 2.0 * 255;
+            a1SampleIndex++;
+            if (a1SampleIndex >= sampleCount) {
+                flushNow = true;
+                a1SampleIndex = 0;
+                uint8_t *tempBuffer = a1FlushSamples;
+                a1FlushSamples = a1Samples;
+                a1Samples = tempBuffer;
+            }
         }
-    }
 
-    output->left = waveform;
-    output->right = waveform + subWaveform;
+        output[n].left = waveform;
+        output[n].right = waveform + subWaveform;
+    }
 }
 
 __attribute__((cold, noinline))
@@ -76,6 +80,8 @@ __attribute__((cold, noinline))
 void ElabApp::ccChangeCallback(uint8_t channel, uint8_t cc, uint8_t value) {
 }
 
+void ElabApp::pitchBendCallback(uint8_t channel, int16_t bend) {}
+
 void ElabApp::bpmChangeCallback(int bpm) {}
 
 __attribute__((cold, noinline))
@@ -85,7 +91,7 @@ void ElabApp::cv1UpdateCallback(uint16_t cv1) {
     // Map CV to musical notes (semitones)
     // Assuming 5 octaves range (60 semitones) from C1 to C6
     int semitone = (int)(normalizedCV * 60.0f);
-    float audioFrequency = 55.0f * powf(2.0f, semitone / 12.0f);
+    float audioFrequency = 55.0f * fastExp2(semitone / 12.0f);
 
     sawWaveform.setFrequency(audioFrequency);
     subSawWaveform.setFrequency(audioFrequency / 2.0f);
@@ -12,7 +12,6 @@ AudioApp* FXRackApp::getInstance() {
 
 void FXRackApp::init() {
     audioManager->setAdcEnabled(true);
-    psram->freeall();
     lowpassFilterA.init(audioManager);
     lowpassFilterB.init(audioManager);
     fx1->init(audioManager);
@@ -27,25 +26,34 @@ void FXRackApp::init() {
     setFX(CONFIG_FX1_INDEX, fx1Value);
     setFX(CONFIG_FX2_INDEX, fx2Value);
     setFX(CONFIG_FX3_INDEX, fx3Value);
+
+    FXRoute routes[FX_GRAPH_SLOTS];
+    loadRoutes(routes);
+    if (!graph.setRoutes(routes, audioManager)) {
+        FXGraph::getDefaultRoutes(routes);
+        graph.setRoutes(routes, audioManager);
+    }
 }
 
 __attribute__((hot))
-void FXRackApp::audioCallback(AudioInput *input, AudioOutput *output) {
-    float sumGroupA = input->left;
-    float sumGroupB = input->right;
-
-    sumGroupA = lowpassFilterA.process(sumGroupA);
-    sumGroupB = lowpassFilterB.process(sumGroupB);
+void FXRackApp::processBlock(const AudioInput* input, AudioOutput* output, size_t frames) {
+    float inputLeft[AUDIO_BLOCK_SIZE], inputRight[AUDIO_BLOCK_SIZE];
+    for (size_t n = 0; n < frames; n++) {
+        inputLeft[n] = input[n].left;
+        inputRight[n] = input[n].right;
+    }
 
-    // Apply FX to group A
-    sumGroupA = fx1->process(sumGroupA);
-    sumGroupA = fx2->process(sumGroupA);
+    lowpassFilterA.processBlock(inputLeft, frames);
+    lowpassFilterB.processBlock(inputRight, frames);
 
-    // Apply FX to group B
-    sumGroupB = fx3->process(sumGroupB);
+    // The FX slots, wired up by the routing schedule
+    float outputLeft[AUDIO_BLOCK_SIZE], outputRight[AUDIO_BLOCK_SIZE];
+    graph.process(inputLeft, inputRight, outputLeft, outputRight, frames);
 
-    output->left = sumGroupA;
-    output->right = sumGroupB;
+    for (size_t n = 0; n < frames; n++) {
+        output[n].left = outputLeft[n];
+        output[n].right = outputRight[n];
+    }
 }
 
 __attribute__((cold, noinline))
@@ -98,17 +106,20 @@ void FXRackApp::ccChangeCallback(uint8_t channel, uint8_t cc, uint8_t value) {
     }
 }
 
+__attribute__((cold, noinline))
+void FXRackApp::pitchBendCallback(uint8_t channel, int16_t bend) {}
+
 __attribute__((cold, noinline))
 void FXRackApp::cv1UpdateCallback(uint16_t cv1) {
     float cv1Norm = 1.0 - IO::normalizeCV(cv1);
-    float cutoff = 1000.0f * powf(20000.0f / 1000.0f, cv1Norm * cv1Norm);
+    float cutoff = expRange(1000.0f, 20000.0f, cv1Norm * cv1Norm);
     lowpassFilterA.setCutoff(cutoff);
 }
 
 __attribute__((cold, noinline))
 void FXRackApp::cv2UpdateCallback(uint16_t cv2) {
     float cv2Norm = 1.0 - IO::normalizeCV(cv2);
-    float cutoff = 1000.0f * powf(20000.0f / 1000.0f, cv2Norm * cv2Norm);
+    float cutoff = expRange(1000.0f, 20000.0f, cv2Norm * cv2Norm);
     lowpassFilterB.setCutoff(cutoff);
 }
 
@@ -117,13 +128,13 @@ void FXRackApp::buttonPressedCallback(bool pressed) {}
 
 void FXRackApp::bpmChangeCallback(int bpm) {
     currentBPM = bpm;
-    fx1->setBPM(bpm);
-    fx2->setBPM(bpm);
-    fx3->setBPM(bpm);
+    fx1.setBPM(bpm);
+    fx2.setBPM(bpm);
+    fx3.setBPM(bpm);
 }
 
-void FXRackApp::setFX(int8_t index, int8_t value) {
-    AudioFX** targetFx = nullptr;
+bool FXRackApp::setFX(int8_t index, int8_t value) {
+    FXSlot* targetFx = nullptr;
     switch (index) {
         case CONFIG_FX1_INDEX:
             targetFx = &fx1;
@@ -135,7 +146,7 @@ void FXRackApp::setFX(int8_t index, int8_t value) {
             targetFx = &fx3;
             break;
         default:
-            return;
+            return false;
     }
 
     AudioFX* newFx = nullptr;
@@ -150,14 +161,44 @@ void FXRackApp::setFX(int8_t index, int8_t value) {
             newFx = new MetalVerbFX;
             break;
         default:
-            return;
+            return false;
     }
 
+    // Prepared here on core0 (its filters design their own coefficients
+    // rather than share the audio core's BiquadCache); the slot
+    // crossfades to it if audio is running, after any swap still fading
     newFx->init(audioManager);
     newFx->setBPM(currentBPM);
-    AudioFX* fxToDelete = *targetFx;
-    *targetFx = newFx;
-    delete fxToDelete;
+    targetFx->set(newFx, audioManager);
+    return true;
+}
+
+// Routes are stored a byte per field; a field never saved reads as the default
+void FXRackApp::loadRoutes(FXRoute routes[FX_GRAPH_SLOTS]) {
+    FXGraph::getDefaultRoutes(routes);
+    for (uint8_t i = 0; i < FX_GRAPH_SLOTS; i++) {
+        int8_t base = CONFIG_ROUTE_INDEX + i * CONFIG_ROUTE_FIELDS;
+        FXRoute& route = routes[i];
+        route.source = config.get(base + 0, route.source);
+        route.send = config.get(base + 1, route.send);
+        route.wet = config.get(base + 2, route.wet);
+        route.output = config.get(base + 3, route.output);
+        route.level = config.get(base + 4, route.level);
+    }
+}
+
+// Saved from update() once the routing has settled (see Config::saveLater())
+void FXRackApp::saveRoutes(const FXRoute routes[FX_GRAPH_SLOTS]) {
+    for (uint8_t i = 0; i < FX_GRAPH_SLOTS; i++) {
+        int8_t base = CONFIG_ROUTE_INDEX + i * CONFIG_ROUTE_FIELDS;
+        const FXRoute& route = routes[i];
+        config.set(base + 0, route.source);
+        config.set(base + 1, route.send);
+        config.set(base + 2, route.wet);
+        config.set(base + 3, route.output);
+        config.set(base + 4, route.level);
+    }
+    config.saveLater();
 }
 
 __attribute__((cold, noinline))
@@ -190,10 +231,12 @@ bool FXRackApp::onCommandCallback(const char* cmd) {
             return true;
         }
 
-        audioManager->stop();
-        config.set(fxIndex, newFx);
-        config.save();
-        audioManager->start();
+        // Swapped live, with a crossfade. Saved from update() once the
+        // choice has settled.
+        if (setFX(fxIndex, newFx)) {
+            config.set(fxIndex, newFx);
+            config.saveLater();
+        }
         return true;
     }
 
@@ -223,8 +266,80 @@ bool FXRackApp::onCommandCallback(const char* cmd) {
         return true;
     }
 
+    // Parse: set-route<fx-id> <source> <send> <wet> <output> <level>
+    if (strncmp(cmd, "set-route", 9) == 0) {
+        int slot = cmd[9] - '1';
+        char sourceName[8], outputName[8];
+        int send, wet, level;
+        if (slot < 0 || slot >= FX_GRAPH_SLOTS ||
+            sscanf(cmd + 10, " %7s %d %d %7s %d", sourceName, &send, &wet, outputName, &level) != 5) {
+            printf("Usage: set-route<fx-id> left|right|mid|side|stereo|fx<n> <send> <wet> none|left|right|stereo|side <level>\n");
+            return true;
+        }
+
+        FXRoute routes[FX_GRAPH_SLOTS];
+        loadRoutes(routes);
+        FXRoute& route = routes[slot];
+        route.source = FX_SOURCE_COUNT;
+        for (uint8_t i = 0; i < FX_SOURCE_COUNT; i++) {
+            if (strcmp(sourceName, FXGraph::getSourceName(i)) == 0) {
+                route.source = i;
+            }
+        }
+        route.output = FX_OUTPUT_COUNT;
+        for (uint8_t i = 0; i < FX_OUTPUT_COUNT; i++) {
+            if (strcmp(outputName, FXGraph::getOutputName(i)) == 0) {
+                route.output = i;
+            }
+        }
+        // Out of range ends up above 100 and is refused with the rest
+        route.send = send < 0 ? 255 : MIN(send, 255);
+        route.wet = wet < 0 ? 255 : MIN(wet, 255);
+        route.level = level < 0 ? 255 : MIN(level, 255);
+
+        // Takes effect from the next block
+        if (graph.setRoutes(routes, audioManager)) {
+            saveRoutes(routes);
+        }
+        return true;
+    }
+
+    // Parse: get-route<fx-id>
+    if (strncmp(cmd, "get-route", 9) == 0) {
+        int slot = cmd[9] - '1';
+        if (slot < 0 || slot >= FX_GRAPH_SLOTS) {
+            printf("Usage: get-route<fx-id>\n");
+            return true;
+        }
+
+        FXRoute routes[FX_GRAPH_SLOTS];
+        loadRoutes(routes);
+        const FXRoute& route = routes[slot];
+        char value[48];
+        snprintf(value, sizeof(value), "%s,%d,%d,%s,%d", FXGraph::getSourceName(route.source), route.send,
+            route.wet, FXGraph::getOutputName(route.output), route.level);
+        webSerial->sendValue(value);
+        return true;
+    }
+
+    // Back to 1 -> 2 on the left, 3 on the right
+    if (strncmp(cmd, "reset-routes", 12) == 0) {
+        FXRoute routes[FX_GRAPH_SLOTS];
+        FXGraph::getDefaultRoutes(routes);
+        if (graph.setRoutes(routes, audioManager)) {
+            saveRoutes(routes);
+        }
+        return true;
+    }
+
     return false;
 }
 
-void FXRackApp::update() {}
+// Deletes effects that finished fading out, and saves settled config changes
+void FXRackApp::update() {
+    fx1.collect();
+    fx2.collect();
+    fx3.collect();
+    config.saveIfIdle();
+}
 
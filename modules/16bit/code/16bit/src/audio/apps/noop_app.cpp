@@ -7,7 +7,12 @@ void NoopApp::init() {
 }
 
 __attribute__((hot))
-void NoopApp::audioCallback(AudioInput *input, AudioOutput *output) {}
+void NoopApp::processBlock(const AudioInput* input, AudioOutput* output, size_t frames) {
+    for (size_t n = 0; n < frames; n++) {
+        output[n].left = 0.0f;
+        output[n].right = 0.0f;
+    }
+}
 
 __attribute__((cold, noinline))
 void NoopApp::update() {}
@@ -21,6 +26,9 @@ void NoopApp::noteOffCallback(uint8_t channel, uint8_t note, uint8_t velocity) {
 __attribute__((cold, noinline))
 void NoopApp::ccChangeCallback(uint8_t channel, uint8_t cc, uint8_t value) {}
 
+__attribute__((cold, noinline))
+void NoopApp::pitchBendCallback(uint8_t channel, int16_t bend) {}
+
 void NoopApp::bpmChangeCallback(int bpm) {}
 
 void NoopApp::cv1UpdateCallback(uint16_t cv1) {}
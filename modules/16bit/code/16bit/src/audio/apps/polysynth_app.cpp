@@ -5,49 +5,83 @@ PolySynthApp* PolySynthApp::instance = nullptr;
 
 void PolySynthApp::init() {
     audioManager->setAdcEnabled(false);
+
+    config.load();
+    int8_t waveformIndex = config.get(CONFIG_WAVEFORM_INDEX, CONFIG_WAVEFORM_SAW);
+
+    // The wavetable is only loaded when it's selected, so other waveforms
+    // don't hold its PSRAM
+    if (waveformIndex == CONFIG_WAVEFORM_WAVETABLE) {
+        WavetableBank::getInstance()->load(config.get(CONFIG_WAVETABLE_SLOT_INDEX, 0));
+    }
+
+    // Wavetables first: the engine sets their frequency
+    for (int i = 0; i < TOTAL_VOICES; i++) {
+        wavetableGenerators[i].init(audioManager);
+    }
+    voiceEngine.init(audioManager, TOTAL_VOICES);
+    voiceEngine.setWavetables(wavetableGenerators);
     for (int i = 0; i < TOTAL_VOICES; i++) {
-        Voice* oldVoice = voices[i];
-        voices[i] = new Voice(
-            1, // total generators
-            (AudioGenerator*[]){ &sawGenerators[i] }, // generators
-            new AttackHoldReleaseEnvelope(10.0f, 500.0f), // amp envelope
-            new AttackHoldReleaseEnvelope(10.0f, 500.0f) // filter envelope
-        );
-        voices[i]->init(audioManager); // init voice
-
-        if (oldVoice != nullptr) {
-            delete oldVoice->getAmpEnvelope();
-            delete oldVoice->getFilterEnvelope();
-            delete oldVoice;
+        if (voices[i] == nullptr) {
+            voices[i] = new Voice(&voiceEngine, i);
         }
     }
 
     fx1->init(audioManager);
 
-    config.load();
-    int8_t waveformIndex = config.get(CONFIG_WAVEFORM_INDEX, CONFIG_WAVEFORM_SAW);
+    voiceAllocator.init(TOTAL_VOICES);
+    voiceAllocator.setStealMode(getVoiceStealMode());
+
     setWaveform(waveformIndex);
 }
 
-__attribute__((hot))
-void PolySynthApp::audioCallback(AudioInput *input, AudioOutput *output) {
-    float sumVoice = 0.0f;
-    for (int i = 0; i < TOTAL_VOICES; i++) {
-        if (voices[i] != nullptr) {
-            sumVoice += voices[i]->process();            
-        }
+// The saved policy, or the default if the config holds something else
+VoiceStealMode PolySynthApp::getVoiceStealMode() {
+    int8_t mode = config.get(CONFIG_VOICE_STEAL_INDEX, VOICE_STEAL_RETRIGGER);
+    if (mode < 0 || mode >= VOICE_STEAL_MODE_COUNT) {
+        return VOICE_STEAL_RETRIGGER;
     }
+    return (VoiceStealMode)mode;
+}
 
-    sumVoice = sumVoice / (MAX(3, TOTAL_VOICES / 2));
+__attribute__((hot))
+void PolySynthApp::processBlock(const AudioInput* input, AudioOutput* output, size_t frames) {
+    float sumVoice[AUDIO_BLOCK_SIZE] = {};
+    voiceEngine.render(sumVoice, frames);
+
+    // Voices that went silent in this block can take new notes
+    uint32_t finished = voiceEngine.takeFinished();
+    while (finished != 0) {
+        uint8_t voice = __builtin_ctz(finished);
+        voiceAllocator.voiceFinished(voice);
+        finished &= finished - 1;
+    }
 
-    float voiceWithFx = sumVoice;
-    voiceWithFx = fx1->process(voiceWithFx);
+    // The filter takes the left output; the right one stays dry
+    float fxLeft[AUDIO_BLOCK_SIZE], fxRight[AUDIO_BLOCK_SIZE];
+    for (size_t n = 0; n < frames; n++) {
+        sumVoice[n] *= VOICE_MIX_GAIN;
+        fxLeft[n] = sumVoice[n];
+        fxRight[n] = sumVoice[n];
+    }
+    fx1->processBlock(fxLeft, fxRight, frames);
 
-    output->left = voiceWithFx;
-    output->right = sumVoice;
+    for (size_t n = 0; n < frames; n++) {
+        output[n].left = fxLeft[n];
+        output[n].right = sumVoice[n];
+    }
 }
 
-void PolySynthApp::update() {}
+void PolySynthApp::update() {
+    if (waveform == CONFIG_WAVEFORM_WAVETABLE) {
+        for (int i = 0; i < TOTAL_VOICES; i++) {
+            if (voices[i]->isActive()) {
+                wavetableGenerators[i].updateCache();
+            }
+        }
+    }
+    config.saveIfIdle();
+}
 
 __attribute__((cold, noinline))
 void PolySynthApp::noteOnCallback(uint8_t channel, uint8_t note, uint8_t velocity) {
@@ -59,13 +93,19 @@ void PolySynthApp::noteOnCallback(uint8_t channel, uint8_t note, uint8_t velocit
         io->setGate1(true);
     }
 
-    Voice* voice = findFreeVoice();
-    if (voice == nullptr) {
+    VoiceAssignment assignment = voiceAllocator.noteOn(note, [this](uint8_t voice) {
+        return voices[voice]->getLevel();
+    });
+    if (assignment.voice == VOICE_NONE) {
         return;
     }
 
-    uint8_t generatorNotes[] = { static_cast<uint8_t>(note) };
-    voice->setNoteOn(realVelocity, note, generatorNotes);
+    Voice* voice = voices[assignment.voice];
+    if (assignment.stolen) {
+        voice->steal(realVelocity, note);
+    } else {
+        voice->setNoteOn(realVelocity, note);
+    }
 }
 
 __attribute__((cold, noinline))
@@ -76,10 +116,9 @@ void PolySynthApp::noteOffCallback(uint8_t channel, uint8_t note, uint8_t veloci
         io->setGate1(false);
     }
 
-    for (int i = 0; i < TOTAL_VOICES; i++) {
-        if (voices[i]->getCurrentNote() == note) {
-            voices[i]->setNoteOff(note);
-        }
+    int8_t voice;
+    while ((voice = voiceAllocator.noteOff(note)) != VOICE_NONE) {
+        voices[voice]->setNoteOff(note);
     }
 }
 
@@ -98,6 +137,35 @@ void PolySynthApp::ccChangeCallback(uint8_t channel, uint8_t cc, uint8_t value)
     else if (cc == 23) {
         fx1->setParameter(3, normalizedValue);
     }
+    else if (cc == VOICE_FILTER_CUTOFF_CC) {
+        // 20Hz to 20kHz, evenly spread in octaves
+        voiceEngine.setFilterCutoff(expRange(VOICE_FILTER_MIN_CUTOFF, VOICE_FILTER_MAX_CUTOFF, normalizedValue));
+    }
+    else if (cc == VOICE_FILTER_RESONANCE_CC) {
+        voiceEngine.setFilterResonance(normalizedValue);
+    }
+    else if (cc == VOICE_FILTER_ENV_AMOUNT_CC) {
+        voiceEngine.setFilterEnvAmount(normalizedValue * VOICE_FILTER_MAX_ENV_OCTAVES);
+    }
+    else if (cc == VOICE_FILTER_ENV_RELEASE_CC) {
+        voiceEngine.setFilterReleaseTime(MAX(10, normalizedValue * 2000));
+    }
+    else if (cc == VOICE_FILTER_KEY_TRACK_CC) {
+        voiceEngine.setFilterKeyTrack(normalizedValue);
+    }
+    else if (cc == WAVETABLE_MORPH_CC) {
+        for (int i = 0; i < TOTAL_VOICES; i++) {
+            wavetableGenerators[i].setMorph(normalizedValue);
+        }
+    }
+}
+
+__attribute__((cold, noinline))
+void PolySynthApp::pitchBendCallback(uint8_t channel, int16_t bend) {
+    float ratio = MIDI::semitonesToRatio(MIDI::pitchBendToSemitones(bend, PITCH_BEND_RANGE));
+    for (int i = 0; i < TOTAL_VOICES; i++) {
+        voices[i]->setPitchRatio(ratio);
+    }
 }
 
 void PolySynthApp::bpmChangeCallback(int bpm) {}
@@ -105,36 +173,35 @@ void PolySynthApp::bpmChangeCallback(int bpm) {}
 __attribute__((cold, noinline))
 void PolySynthApp::cv1UpdateCallback(uint16_t cv1) {
     float holdTime = MAX(1, IO::normalizeCV(cv1) * 500);
-    for (int i = 0; i < TOTAL_VOICES; i++) {
-        voices[i]->getAmpEnvelope()->setTime(AttackHoldReleaseEnvelope::ATTACK, holdTime);
-    }
+    voiceEngine.setAttackTime(holdTime);
 }
 
 __attribute__((cold, noinline))
 void PolySynthApp::cv2UpdateCallback(uint16_t cv2) {
     float releaseTime = MAX(10, IO::normalizeCV(cv2) * 1000);
-    for (int i = 0; i < TOTAL_VOICES; i++) {
-        voices[i]->getAmpEnvelope()->setTime(AttackHoldReleaseEnvelope::RELEASE, releaseTime);
-    }
+    voiceEngine.setReleaseTime(releaseTime);
 }
 
 __attribute__((cold, noinline))
 void PolySynthApp::buttonPressedCallback(bool pressed) {}
 
 void PolySynthApp::setWaveform(int8_t waveformIndex) {
-    if (waveformIndex == CONFIG_WAVEFORM_SAW) {
-        for (int i = 0; i < TOTAL_VOICES; i++) {
-            voices[i]->changeGenerators((AudioGenerator*[]){ &sawGenerators[i] });
-        }
-    } else if (waveformIndex == CONFIG_WAVEFORM_TRI) {
-        for (int i = 0; i < TOTAL_VOICES; i++) {
-            voices[i]->changeGenerators((AudioGenerator*[]){ &triGenerators[i] });
-        }
-    } else if (waveformIndex == CONFIG_WAVEFORM_SQUARE) {
-        for (int i = 0; i < TOTAL_VOICES; i++) {
-            voices[i]->changeGenerators((AudioGenerator*[]){ &squareGenerators[i] });
-        }
+    // Config index -> engine waveform
+    const VoiceWaveform waveforms[] = {
+        VOICE_WAVE_SAW,
+        VOICE_WAVE_SQUARE,
+        VOICE_WAVE_TRI,
+        VOICE_WAVE_BL_SAW,
+        VOICE_WAVE_BL_SQUARE,
+        VOICE_WAVE_BL_TRI,
+        VOICE_WAVE_WAVETABLE,
+    };
+    if (waveformIndex < 0 || waveformIndex > CONFIG_WAVEFORM_WAVETABLE) {
+        return;
     }
+
+    voiceEngine.setWaveform(waveforms[waveformIndex]);
+    waveform = waveformIndex;
 }
 
 bool PolySynthApp::onCommandCallback(const char* cmd) {
@@ -142,25 +209,73 @@ bool PolySynthApp::onCommandCallback(const char* cmd) {
         const char* waveformName = cmd + 13;
 
         int8_t waveformIndex = -1;
-        if (strncmp(waveformName, "saw", 3) == 0) {
+        int wavetableSlot = -1;
+        if (sscanf(waveformName, "wt-%d", &wavetableSlot) == 1) {
+            if (wavetableSlot < 0 || wavetableSlot >= WAVETABLE_SLOTS) {
+                printf("Wavetable slot must be 0-%d\n", WAVETABLE_SLOTS - 1);
+                return false;
+            }
+            waveformIndex = CONFIG_WAVEFORM_WAVETABLE;
+        } else if (strncmp(waveformName, "bl-saw", 6) == 0) {
+            waveformIndex = CONFIG_WAVEFORM_BL_SAW;
+        } else if (strncmp(waveformName, "bl-square", 9) == 0) {
+            waveformIndex = CONFIG_WAVEFORM_BL_SQUARE;
+        } else if (strncmp(waveformName, "bl-tri", 6) == 0) {
+            waveformIndex = CONFIG_WAVEFORM_BL_TRI;
+        } else if (strncmp(waveformName, "saw", 3) == 0) {
             waveformIndex = CONFIG_WAVEFORM_SAW;
         } else if (strncmp(waveformName, "tri", 3) == 0) {
             waveformIndex = CONFIG_WAVEFORM_TRI;
         } else if (strncmp(waveformName, "square", 6) == 0) {
             waveformIndex = CONFIG_WAVEFORM_SQUARE;
         } else {
-            printf("Usage: set-waveform saw|tri|square\n");
+            printf("Usage: set-waveform saw|tri|square|bl-saw|bl-tri|bl-square|wt-<slot>\n");
             return false;
         }
 
         audioManager->stop();
         config.set(CONFIG_WAVEFORM_INDEX, waveformIndex);
+        if (waveformIndex == CONFIG_WAVEFORM_WAVETABLE) {
+            config.set(CONFIG_WAVETABLE_SLOT_INDEX, wavetableSlot);
+        }
         config.save();
         audioManager->start();
 
         return true;
     }
 
+    if (strncmp(cmd, "set-voice-steal", 15) == 0) {
+        const char* modeName = cmd + 16;
+
+        VoiceStealMode mode;
+        if (strncmp(modeName, "retrigger", 9) == 0) {
+            mode = VOICE_STEAL_RETRIGGER;
+        } else if (strncmp(modeName, "oldest", 6) == 0) {
+            mode = VOICE_STEAL_OLDEST;
+        } else if (strncmp(modeName, "quietest", 8) == 0) {
+            mode = VOICE_STEAL_QUIETEST;
+        } else {
+            printf("Usage: set-voice-steal retrigger|oldest|quietest\n");
+            return true;
+        }
+
+        audioManager->postCall([](void* context, int32_t arg) {
+            static_cast<VoiceAllocator*>(context)->setStealMode((VoiceStealMode)arg);
+        }, &voiceAllocator, mode);
+        // Saved from update() once it has settled, and only if it changed
+        if (mode != getVoiceStealMode()) {
+            config.set(CONFIG_VOICE_STEAL_INDEX, mode);
+            config.saveLater();
+        }
+        return true;
+    }
+
+    if (strncmp(cmd, "get-voice-steal", 15) == 0) {
+        const char* names[VOICE_STEAL_MODE_COUNT] = { "oldest", "quietest", "retrigger" };
+        webSerial->sendValue(names[getVoiceStealMode()]);
+        return true;
+    }
+
     if (strncmp(cmd, "get-waveform", 12) == 0) {
         int8_t waveformIndex = config.get(CONFIG_WAVEFORM_INDEX, CONFIG_WAVEFORM_SAW);
         if (waveformIndex == CONFIG_WAVEFORM_SAW) {
@@ -169,10 +284,45 @@ bool PolySynthApp::onCommandCallback(const char* cmd) {
             webSerial->sendValue("tri");
         } else if (waveformIndex == CONFIG_WAVEFORM_SQUARE) {
             webSerial->sendValue("square");
+        } else if (waveformIndex == CONFIG_WAVEFORM_BL_SAW) {
+            webSerial->sendValue("bl-saw");
+        } else if (waveformIndex == CONFIG_WAVEFORM_BL_SQUARE) {
+            webSerial->sendValue("bl-square");
+        } else if (waveformIndex == CONFIG_WAVEFORM_BL_TRI) {
+            webSerial->sendValue("bl-tri");
+        } else if (waveformIndex == CONFIG_WAVEFORM_WAVETABLE) {
+            char name[8];
+            snprintf(name, sizeof(name), "wt-%02d", config.get(CONFIG_WAVETABLE_SLOT_INDEX, 0));
+            webSerial->sendValue(name);
         }
         
         return true;
     }
+
+    // Parse: write-wavetable-base64 <slot> <original-size> <base64-length>
+    if (strncmp(cmd, "write-wavetable-base64 ", 23) == 0) {
+        int slot = -1, originalSize = -1, base64Size = -1;
+        if (sscanf(cmd + 23, "%d %d %d", &slot, &originalSize, &base64Size) != 3 ||
+            !(slot >= 0 && slot < WAVETABLE_SLOTS && originalSize > 0 && base64Size > 0)) {
+            printf("Usage: write-wavetable-base64 <slot 0-%d> <original-size> <base64-length>\n", WAVETABLE_SLOTS - 1);
+            return false;
+        }
+
+        bool accepted = webSerial->acceptBinary(originalSize, base64Size, [slot](uint8_t* data, int size) {
+            if (WavetableBank::saveWavetable(slot, data, size)) {
+                printf("Wavetable %02d saved\n", slot);
+            } else {
+                printf("Failed to save wavetable %02d\n", slot);
+            }
+        });
+
+        if (!accepted) {
+            return false;
+        }
+
+        printf("Ready to receive %d Base64 chars for wavetable %02d (original %d bytes)\n", base64Size, slot, originalSize);
+        return true;
+    }
     
     return false;
 }